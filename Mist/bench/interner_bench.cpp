@@ -0,0 +1,122 @@
+// Interns a stream of identifiers from 1 to N threads at once and reports
+// the throughput, first into an empty interner and then again once every
+// name is known. A single lock around an unordered_map is run alongside as
+// the baseline the sharded interner replaces.
+//
+// usage: interner_bench [max threads] [names per thread]
+
+#include "utils/interner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+    const u32 Vocabulary = 50000;
+
+    // names built from syllables, a few short ones like i and x are the most
+    // common just as in real source.
+    std::vector<std::string> make_vocabulary() {
+        static const char* syllables[] = {
+            "get", "set", "len", "buf", "idx", "node", "expr", "decl", "type", "val",
+            "pos", "tok", "scan", "parse", "item", "list", "map", "key", "count", "size",
+            "_", "a", "b", "c", "x", "y", "i", "j", "n", "ptr"
+        };
+        const u32 count = sizeof(syllables) / sizeof(syllables[0]);
+
+        std::vector<std::string> names;
+        std::mt19937 rng(7);
+        for(u32 i = 0; i < 26; ++i)
+            names.emplace_back(1, (char) ('a' + i));
+        while(names.size() < Vocabulary) {
+            std::string name;
+            u32 parts = 1 + rng() % 4;
+            for(u32 p = 0; p < parts; ++p)
+                name += syllables[rng() % count];
+            name += std::to_string(names.size());
+            names.push_back(name);
+        }
+        return names;
+    }
+
+    // a zipf distribution over the vocabulary, rank 0 the most common.
+    std::vector<std::string_view> make_stream(const std::vector<std::string>& names, u32 length, u32 seed) {
+        std::vector<f64> weights(names.size());
+        for(u32 i = 0; i < names.size(); ++i)
+            weights[i] = 1.0 / (i + 1);
+        std::discrete_distribution<u32> zipf(weights.begin(), weights.end());
+        std::mt19937 rng(seed);
+
+        std::vector<std::string_view> stream(length);
+        for(auto& name : stream)
+            name = names[zipf(rng)];
+        return stream;
+    }
+
+    struct Locked {
+        std::mutex mutex;
+        std::unordered_map<std::string, u32> table;
+
+        u32 intern(std::string_view str) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto iter = table.find(std::string(str));
+            if(iter != table.end())
+                return iter->second;
+            u32 id = (u32) table.size() + 1;
+            table.emplace(std::string(str), id);
+            return id;
+        }
+    };
+
+    template <typename Table>
+    f64 run(Table& table, const std::vector<std::vector<std::string_view>>& streams, u32 threads) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        std::vector<u64> sums(threads);
+        for(u32 t = 0; t < threads; ++t)
+            workers.emplace_back([&, t]() {
+                u64 sum = 0;
+                for(auto name : streams[t])
+                    sum += table.intern(name);
+                sums[t] = sum;
+            });
+        for(auto& worker : workers)
+            worker.join();
+        std::chrono::duration<f64> time = std::chrono::steady_clock::now() - start;
+        return time.count();
+    }
+
+    template <typename Table>
+    void measure(const char* name, const std::vector<std::vector<std::string_view>>& streams, u32 threads, u64 total) {
+        Table table;
+        f64 cold = run(table, streams, threads);
+        f64 warm = run(table, streams, threads);
+        printf("%-8s %7u %12.1f %12.1f\n", name, threads, total / cold / 1e6, total / warm / 1e6);
+    }
+}
+
+int main(int argc, const char** argv) {
+    u32 maxThreads = argc > 1 ? (u32) std::strtoul(argv[1], nullptr, 10) : std::max(1u, std::thread::hardware_concurrency());
+    u32 perThread = argc > 2 ? (u32) std::strtoul(argv[2], nullptr, 10) : 1000000;
+
+    auto names = make_vocabulary();
+    std::vector<std::vector<std::string_view>> streams;
+    for(u32 t = 0; t < maxThreads; ++t)
+        streams.push_back(make_stream(names, perThread, t + 1));
+
+    printf("%-8s %7s %12s %12s\n", "table", "threads", "cold Mops/s", "warm Mops/s");
+    for(u32 threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        u64 total = (u64) threads * perThread;
+        measure<mist::Interner>("sharded", streams, threads, total);
+        measure<Locked>("locked", streams, threads, total);
+        if(threads == maxThreads)
+            break;
+    }
+    return 0;
+}
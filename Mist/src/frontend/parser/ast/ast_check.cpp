@@ -0,0 +1,135 @@
+#include "ast_check.hpp"
+#include "ast_flat.hpp"
+#include "ast_visitor.hpp"
+#include "interpreter.hpp"
+
+namespace ast {
+	namespace {
+		// what the nodes are counted by, flatten has a tag for each of them.
+		enum Category {
+			Exprs,
+			Decls,
+			Specs,
+			Idents,
+			Paths,
+			Arms,
+			Wheres,
+			WhereElements,
+			GenericLists,
+			LazyBodies,
+			Categories
+		};
+
+		const char* Names[Categories] = {
+			"expressions", "declarations", "type specs", "identifiers", "use paths",
+			"match arms", "where clauses", "where elements", "generic lists", "skipped bodies"
+		};
+
+		Category category(NodeTag tag) {
+			switch(tag) {
+				case Node_Ident: return Idents;
+				case Node_MatchArm: return Arms;
+				case Node_LazyBody: return LazyBodies;
+				case Node_Generics: return GenericLists;
+				case Node_Where: return Wheres;
+				case Node_WhereElement: return WhereElements;
+				case Node_Path: return Paths;
+				default:
+					break;
+			}
+			if(tag >= Node_NamedSpec)
+				return Specs;
+			if(tag >= Node_Local)
+				return Decls;
+			return Exprs;
+		}
+
+		struct Counter : public Visitor<Counter> {
+			u32 counts[Categories] = {};
+
+			Walk count(Category category) {
+				++counts[category];
+				return Recurse;
+			}
+
+			Walk enter_expr(Expr*) { return count(Exprs); }
+			Walk enter_decl(Decl*) { return count(Decls); }
+			Walk enter_spec(TypeSpec*) { return count(Specs); }
+			Walk enter_ident(Ident*) { return count(Idents); }
+			Walk enter_path(UsePath*) { return count(Paths); }
+			Walk enter_match_arm(MatchArm*) { return count(Arms); }
+			Walk enter_where(WhereClause*) { return count(Wheres); }
+			Walk enter_where_element(WhereElement*) { return count(WhereElements); }
+			Walk enter_generics(Generics*) { return count(GenericLists); }
+
+			// flatten keeps a skipped body as it is.
+			Walk enter_lazy_body(LazyBody*) {
+				count(LazyBodies);
+				return Prune;
+			}
+		};
+
+		// positions are in [base, base + size], the end of file sits at base + size.
+		struct Bounds : public Visitor<Bounds> {
+			u64 base;
+			u64 size;
+			u32 outside{0};
+			mist::Pos first;		// the first position outside
+
+			Bounds(u64 base, u64 size) : base(base), size(size) {}
+
+			Walk inside(const mist::Pos& pos) {
+				if(pos.offset && (pos.offset < base || pos.offset + (u64) pos.span > base + size)) {
+					if(!outside++)
+						first = pos;
+				}
+				return Recurse;
+			}
+
+			Walk enter_expr(Expr* e) { return inside(e->p); }
+			Walk enter_decl(Decl* d) { return inside(d->pos); }
+			Walk enter_spec(TypeSpec* s) { return inside(s->p); }
+			Walk enter_ident(Ident* i) { return inside(i->pos); }
+			Walk enter_path(UsePath* p) { return inside(p->pos); }
+			Walk enter_where(WhereClause* w) { return inside(w->pos); }
+			Walk enter_where_element(WhereElement* e) { return inside(e->pos); }
+
+			// the range of a skipped body is in the file, not the address space.
+			Walk enter_lazy_body(LazyBody* lazy) {
+				if(lazy->begin > lazy->end || lazy->end > size) {
+					if(!outside++)
+						first = mist::Pos((u32) (base + lazy->begin), lazy->end - lazy->begin);
+				}
+				return Prune;
+			}
+		};
+	}
+
+	bool check(Module* module, mist::Interpreter* interp, std::ostream& out) {
+		Counter counter;
+		Bounds bounds(interp->sources().base(module->file), module->file->size());
+		Fused<Counter, Bounds> passes(counter, bounds);
+		passes.walk(module);
+
+		u32 flat[Categories] = {};
+		auto tree = flatten(module);
+		// handle 0 is no node.
+		for(u32 i = 1; i < tree.size(); ++i)
+			++flat[category(tree.tag(i))];
+
+		bool clean = true;
+		auto& name = module->file->name();
+		for(u32 i = 0; i < Categories; ++i) {
+			if(counter.counts[i] == flat[i])
+				continue;
+			out << name << ": the walk reached " << counter.counts[i] << " " << Names[i] << ", flatten stored " << flat[i] << std::endl;
+			clean = false;
+		}
+		if(bounds.outside) {
+			out << name << ": " << bounds.outside << " positions are outside of the file, the first at "
+				<< bounds.first.offset << "+" << bounds.first.span << std::endl;
+			clean = false;
+		}
+		return clean;
+	}
+}
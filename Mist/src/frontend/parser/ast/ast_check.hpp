@@ -0,0 +1,15 @@
+#pragma once
+
+#include "ast_common.hpp"
+
+#include <ostream>
+
+namespace ast {
+
+	/// Walks module with two fused ast::Visitor passes, one counting the
+	/// nodes of each category and one checking that every position lies in
+	/// the file of the module, and compares the counts with ast::flatten.
+	/// Skipped bodies stay skipped. Each difference is written to out, false
+	/// when there is any.
+	bool check(Module* module, mist::Interpreter* interp, std::ostream& out);
+}
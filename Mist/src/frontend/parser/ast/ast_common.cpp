@@ -3,26 +3,30 @@
 
 namespace mist {
     Pos::Pos() = default;
-    Pos::Pos(u32 line, u32 column, u32 span, u64 fileId) : line(line), column(column),
-        span(span), fileId(fileId) {}
+    Pos::Pos(u32 offset, u32 span) : offset(offset), span(span) {}
 
     Pos Pos::operator+ (const Pos& p) {
-        Pos pos = *this;
-        pos.span += p.span;
-        return pos;
+        if(!p.offset) return *this;
+        if(!offset) return p;
+        u32 first = offset < p.offset ? offset : p.offset;
+        u32 last = offset + span > p.offset + p.span ? offset + span : p.offset + p.span;
+        return Pos(first, last - first);
     }
 }
 
 namespace ast {
-    Ident::Ident(mist::String* value,
+    Ident::Ident(u32 value,
         const mist::Pos& pos) : value(value), pos(pos) { }
 
-    WhereElement::WhereElement(Ident* parameter, const std::vector<TypeSpec*>& type,
+    WhereElement::WhereElement(Ident* parameter, mist::Span<TypeSpec*> type,
         mist::Pos pos) : parameter(parameter), type(type), pos(pos) { }
 
-    WhereClause::WhereClause(const std::vector<WhereElement*>& elems,
+    WhereClause::WhereClause(mist::Span<WhereElement*> elems,
         mist::Pos pos) : elements(elems), pos(pos) { }
 
+    UsePath::UsePath(mist::Span<Ident*> names,
+        mist::Pos pos) : names(names), pos(pos) { }
+
     Module::Module(io::File* file) : file(file) {}
 
     void Module::add_decl(Decl* d) {
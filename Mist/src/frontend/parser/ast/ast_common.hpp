@@ -1,6 +1,8 @@
 #pragma once
 
 #include "common.hpp"
+#include "utils/arena.hpp"
+#include <mutex>
 #include <vector>
 
 namespace io {
@@ -8,20 +10,24 @@ namespace io {
 }
 
 namespace mist {
+    /// A range of source text. The offset is in the address space of the
+    /// io::SourceManager, line and column are only looked up to print it.
     struct Pos {
-        u32 line{0};
-        u32 column{0};
+        u32 offset{0};      /// 0 is not in any file
         u32 span{0};
-        ::u64 fileId{0};
 
         Pos();
 
-        Pos(u32 line, u32 column, u32 span, ::u64 fileId = 0);
+        Pos(u32 offset, u32 span);
 
+        /// the range covering both positions.
         Pos operator+ (const Pos& p);
     };
 
+    static_assert(sizeof(Pos) == 8, "every node holds a position");
+
 	struct String;
+	class Interpreter;
 }
 
 namespace ast {
@@ -38,38 +44,45 @@ namespace ast {
     };
 
     struct Ident {
-        mist::String* value;
+        u32 value;          /// symbol id in the interner
         mist::Pos pos;
 
-        Ident(mist::String* value, const mist::Pos& pos);
+        Ident(u32 value, const mist::Pos& pos);
     };
 
     struct TypeSpec;
 
     struct WhereElement {
         Ident* parameter;
-        std::vector<TypeSpec*> type;
+        mist::Span<TypeSpec*> type;
         mist::Pos pos;
 
-        WhereElement(Ident* parameter, const std::vector<TypeSpec*>& type, mist::Pos pos);
+        WhereElement(Ident* parameter, mist::Span<TypeSpec*> type, mist::Pos pos);
     };
 
     struct WhereClause {
-        std::vector<WhereElement*> elements;
+        mist::Span<WhereElement*> elements;
         mist::Pos pos;
 
-        WhereClause(const std::vector<WhereElement*>& elems, mist::Pos pos);
+        WhereClause(mist::Span<WhereElement*> elems, mist::Pos pos);
     };
 
-    struct Path {
-        // std::vector<PathElement*> fields;
-        // Path(const std::vector<PathElement*> fields);
+    /// the dotted name of a use declaration, a.b.c
+    struct UsePath {
+        mist::Span<Ident*> names;
+        mist::Pos pos;
+
+        UsePath(mist::Span<Ident*> names, mist::Pos pos);
     };
 
     struct Module {
         // file
         io::File* file;
         std::vector<Decl*> toplevelDeclarations;
+        mist::Arena arena;      /// every node of the module and its lists
+
+        mist::Interpreter* interp{nullptr};     /// set when function bodies were skipped, they are parsed on first use
+        std::mutex mutex;       /// taken while a skipped body is parsed into the arena
 
         Module(io::File* file);
 
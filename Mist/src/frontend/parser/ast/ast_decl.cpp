@@ -1,11 +1,12 @@
 #include "ast_decl.hpp"
 
 #include "ast_common.hpp"
+#include "frontend/parser/parser.hpp"
 
 #define ToString(x) #x
 
 namespace ast {
-	const static std::vector<std::string> decl_strings = {
+	static constexpr const char* decl_strings[] = {
 		ToString(Local),
 		ToString(MultiLocal),
 		ToString(Struct),
@@ -31,14 +32,14 @@ namespace ast {
 		return t;
 	}
 
-	const std::string& Decl::string() {
+	const char* Decl::string() {
 		return decl_strings[k];
 	}
 
-	GenericDecl::GenericDecl(Ident* name, const std::vector<TypeSpec*>& bounds, mist::Pos pos) :
+	GenericDecl::GenericDecl(Ident* name, mist::Span<TypeSpec*> bounds, mist::Pos pos) :
 		Decl(name, Generic, pos), bounds(bounds) {}
 
-	Generics::Generics(const std::vector<GenericDecl*>& parameters) : parameters(parameters) {
+	Generics::Generics(mist::Span<GenericDecl*> parameters) : parameters(parameters) {
 
 	}
 
@@ -55,43 +56,61 @@ namespace ast {
 		return sp;
 	}
 
-	MultiLocalDecl::MultiLocalDecl(const std::vector<Ident*>& names, const std::vector<TypeSpec*>& sps,
-		const std::vector<Expr*>& inits, mist::Pos pos) : Decl(nullptr, MultiLocal, pos), names(names), sps(sps), inits(inits) {
+	MultiLocalDecl::MultiLocalDecl(mist::Span<Ident*> names, mist::Span<TypeSpec*> sps,
+		mist::Span<Expr*> inits, mist::Pos pos) : Decl(nullptr, MultiLocal, pos), names(names), sps(sps), inits(inits) {
 
 	}
 
-	StructDecl::StructDecl(Ident* name, const std::vector<FieldDecl*>& fields, const std::vector<TypeSpec*>& derives, WhereClause* where, Generics* gen, mist::Pos pos) :
+	StructDecl::StructDecl(Ident* name, mist::Span<FieldDecl*> fields, mist::Span<TypeSpec*> derives, WhereClause* where, Generics* gen, mist::Pos pos) :
 		Decl(name, Struct, pos), fields(fields), derives(derives), where(where), generics(gen) {
 	}
 
-	FunctionDecl::FunctionDecl(Ident* ident, const std::vector<FieldDecl*>& params,
-		const std::vector<TypeSpec*>& rets, Expr* body, Generics* gen, mist::Pos pos) :
-		Decl(ident, Function, pos), parameters(params), returns(rets), body(body), generics(gen) {
+	LazyBody::LazyBody(Module* module, u32 begin, u32 end, u32 res) :
+		module(module), begin(begin), end(end), res(res) {
 	}
 
-	OpFunctionDecl::OpFunctionDecl(Op name, const std::vector<FieldDecl*>& params,
-		const std::vector<TypeSpec*>& rets, Expr* body, Generics* gen, mist::Pos pos) : Decl(nullptr, OpFunction, pos), op(name), parameters(params), returns(rets), generics(gen), body(body) {
+	FunctionDecl::FunctionDecl(Ident* ident, mist::Span<FieldDecl*> params,
+		mist::Span<TypeSpec*> rets, Expr* body, Generics* gen, mist::Pos pos) :
+		Decl(ident, Function, pos), parameters(params), returns(rets), parsed(body), generics(gen) {
 	}
 
-	TypeClassDecl::TypeClassDecl(Ident* ident, const std::vector<Decl*>& members, Generics* gen, mist::Pos pos) :
+	Expr* FunctionDecl::body() {
+		auto expr = parsed.load(std::memory_order_acquire);
+		if(!expr && lazy)
+			return mist::Parser::parse_lazy_body(lazy, parsed);
+		return expr;
+	}
+
+	OpFunctionDecl::OpFunctionDecl(Op name, mist::Span<FieldDecl*> params,
+		mist::Span<TypeSpec*> rets, Expr* body, Generics* gen, mist::Pos pos) : Decl(nullptr, OpFunction, pos), op(name), parameters(params), returns(rets), parsed(body), generics(gen) {
+	}
+
+	Expr* OpFunctionDecl::body() {
+		auto expr = parsed.load(std::memory_order_acquire);
+		if(!expr && lazy)
+			return mist::Parser::parse_lazy_body(lazy, parsed);
+		return expr;
+	}
+
+	TypeClassDecl::TypeClassDecl(Ident* ident, mist::Span<Decl*> members, Generics* gen, mist::Pos pos) :
 		Decl(ident, TypeClass, pos), members(members), generics(gen) {
 	}
 
-	UseDecl::UseDecl(Ident* ident, Path* path, const std::vector<Path*> fields, mist::Pos pos) :
+	UseDecl::UseDecl(Ident* ident, UsePath* path, mist::Span<UsePath*> fields, mist::Pos pos) :
 		Decl(ident, Use, pos), path(path), fields(fields) {
 	}
 
-	ImplDecl::ImplDecl(Ident* ident, const std::vector<FunctionDecl*>& methods, Generics* gen, mist::Pos pos) :
+	ImplDecl::ImplDecl(Ident* ident, mist::Span<FunctionDecl*> methods, Generics* gen, mist::Pos pos) :
 		Decl(ident, Impl, pos), methods(methods), generics(gen) {
 	}
 
 	EnumMemberDecl::EnumMemberDecl(Ident* name, EnumDeclKind ekind, mist::Pos pos,
-		const std::vector<TypeSpec*>& types, Expr* init) : Decl(name, EnumMember, pos),
+		mist::Span<TypeSpec*> types, Expr* init) : Decl(name, EnumMember, pos),
 		types(types), init(init), ekind(ekind) {
 
 	}
 
-	EnumDecl::EnumDecl(Ident* name, const std::vector<EnumMemberDecl*> members, Generics* gen,
+	EnumDecl::EnumDecl(Ident* name, mist::Span<EnumMemberDecl*> members, Generics* gen,
 		mist::Pos pos) : Decl(name, Enum, pos), members(members), generics(gen) {
 	}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ast_common.hpp"
+#include <atomic>
 
 namespace ast {
 
@@ -42,7 +43,8 @@ namespace ast {
 		OpGreaterEqual,
 		OpEqualEqual,
 		OpBangEqual,
-		OpParenthesis
+		OpParenthesis,
+		OpUnknown		// the operator could not be parsed
 	};
 
 	struct Decl {
@@ -58,19 +60,19 @@ namespace ast {
 
 		Type* type();
 
-		const std::string& string();
+		const char* string();
 	};
 
 	struct GenericDecl :  public Decl {
-		std::vector<TypeSpec*> bounds;
+		mist::Span<TypeSpec*> bounds;
 
-		GenericDecl(Ident* name, const std::vector<TypeSpec*>& bounds, mist::Pos pos);
+		GenericDecl(Ident* name, mist::Span<TypeSpec*> bounds, mist::Pos pos);
 	};
 
 	struct Generics {
-		std::vector<GenericDecl*> parameters;
+		mist::Span<GenericDecl*> parameters;
 
-		Generics(const std::vector<GenericDecl*>& parameters);
+		Generics(mist::Span<GenericDecl*> parameters);
 	};
 
 
@@ -89,65 +91,83 @@ namespace ast {
 	// x, y, z : i32, f32, string = 1, 2.0, "Hello, World"
 	struct MultiLocalDecl : public Decl {
 
-		std::vector<Ident*> names;
-		std::vector<TypeSpec*> sps;
-		std::vector<Expr*> inits;
+		mist::Span<Ident*> names;
+		mist::Span<TypeSpec*> sps;
+		mist::Span<Expr*> inits;
 
-		MultiLocalDecl(const std::vector<Ident*>& names, const std::vector<TypeSpec*>& sp, 
-			const std::vector<Expr*>& init, mist::Pos pos);
+		MultiLocalDecl(mist::Span<Ident*> names, mist::Span<TypeSpec*> sp, 
+			mist::Span<Expr*> init, mist::Pos pos);
 	};
 
 	typedef LocalDecl FieldDecl;
 	
 	struct StructDecl : public Decl {
-		std::vector<FieldDecl*> fields;
-		std::vector<TypeSpec*> derives;
+		mist::Span<FieldDecl*> fields;
+		mist::Span<TypeSpec*> derives;
 		WhereClause* where{nullptr};
 		Generics* generics{nullptr};
 
-		StructDecl(Ident* name, const std::vector<FieldDecl*>& fields, const std::vector<TypeSpec*>& derives, WhereClause* where, Generics* gen, mist::Pos pos);
+		StructDecl(Ident* name, mist::Span<FieldDecl*> fields, mist::Span<TypeSpec*> derives, WhereClause* where, Generics* gen, mist::Pos pos);
 	};
 	
+	// a function body the parser skipped, it is parsed the first time it is asked for.
+	struct LazyBody {
+		Module* module;
+		u32 begin;			// offset of the '{' opening the body in the file
+		u32 end;			// offset just past the matching '}'
+		u32 res;			// the restrictions the body is parsed with
+		bool done{false};	// parsed, even if that failed. Guarded by the mutex of the module
+
+		LazyBody(Module* module, u32 begin, u32 end, u32 res);
+	};
+
 	struct FunctionDecl : public Decl {
-		std::vector<FieldDecl*> parameters;
-		std::vector<TypeSpec*> returns;
-		Expr* body{nullptr};
+		mist::Span<FieldDecl*> parameters;
+		mist::Span<TypeSpec*> returns;
+		std::atomic<Expr*> parsed{nullptr};	// the body once it has been parsed
+		LazyBody* lazy{nullptr};
 		Generics* generics{nullptr};
 
-		FunctionDecl(Ident* ident, const std::vector<FieldDecl*>& params,
-					 const std::vector<TypeSpec*>& rets, Expr* body, Generics* gen, mist::Pos pos);
+		FunctionDecl(Ident* ident, mist::Span<FieldDecl*> params,
+					 mist::Span<TypeSpec*> rets, Expr* body, Generics* gen, mist::Pos pos);
+
+		/// the body, a skipped body is parsed here. Any thread may call this.
+		Expr* body();
 	};
 
 	struct OpFunctionDecl : public Decl {
 		Op op;	
-		std::vector<FieldDecl*> parameters;
-		std::vector<TypeSpec*> returns;
-		Expr* body{nullptr};
+		mist::Span<FieldDecl*> parameters;
+		mist::Span<TypeSpec*> returns;
+		std::atomic<Expr*> parsed{nullptr};
+		LazyBody* lazy{nullptr};
 		Generics* generics{nullptr};
 
-		OpFunctionDecl(Op name, const std::vector<FieldDecl*>& params,
-					 const std::vector<TypeSpec*>& rets, Expr* body, Generics* gen, mist::Pos pos);
+		OpFunctionDecl(Op name, mist::Span<FieldDecl*> params,
+					 mist::Span<TypeSpec*> rets, Expr* body, Generics* gen, mist::Pos pos);
+
+		Expr* body();
 	};
 
 	struct TypeClassDecl : public Decl {
-		std::vector<Decl*> members;		
+		mist::Span<Decl*> members;		
 		Generics* generics;
 
-		TypeClassDecl(Ident* ident, const std::vector<Decl*>& members, Generics* gen, mist::Pos pos);
+		TypeClassDecl(Ident* ident, mist::Span<Decl*> members, Generics* gen, mist::Pos pos);
 	};
 	
 	struct UseDecl : public Decl {
-		Path* path;	
-		std::vector<Path*> fields;
+		UsePath* path;	
+		mist::Span<UsePath*> fields;
 
-		UseDecl(Ident* ident, Path* path, const std::vector<Path*> fields, mist::Pos pos);
+		UseDecl(Ident* ident, UsePath* path, mist::Span<UsePath*> fields, mist::Pos pos);
 	};
 	
 	struct ImplDecl : public Decl {
-		std::vector<FunctionDecl*> methods;		
+		mist::Span<FunctionDecl*> methods;		
 		Generics* generics;
 
-		ImplDecl(Ident* ident, const std::vector<FunctionDecl*>& methods, Generics* gen, mist::Pos pos);
+		ImplDecl(Ident* ident, mist::Span<FunctionDecl*> methods, Generics* gen, mist::Pos pos);
 	};
 
 	enum EnumDeclKind {
@@ -158,17 +178,17 @@ namespace ast {
 	struct EnumMemberDecl : public Decl {
 		EnumDeclKind ekind;
 		Expr* init{nullptr};
-		std::vector<TypeSpec*> types;
+		mist::Span<TypeSpec*> types;
 
-		EnumMemberDecl(Ident* name, EnumDeclKind ekind, mist::Pos pos, const 
-			std::vector<TypeSpec*>& types = std::vector<TypeSpec*>(), Expr* init = nullptr);
+		EnumMemberDecl(Ident* name, EnumDeclKind ekind, mist::Pos pos,
+			mist::Span<TypeSpec*> types = mist::Span<TypeSpec*>(), Expr* init = nullptr);
 	};
 
 	struct EnumDecl : public Decl {
-		std::vector<EnumMemberDecl*> members;
+		mist::Span<EnumMemberDecl*> members;
 		Generics* generics;
 
-		EnumDecl(Ident* name, const std::vector<EnumMemberDecl*> members, Generics* gen, mist::Pos pos);
+		EnumDecl(Ident* name, mist::Span<EnumMemberDecl*> members, Generics* gen, mist::Pos pos);
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,641 @@
+#include "ast_emitter.hpp"
+#include "interpreter.hpp"
+#include "frontend/parser/tokenizer/token.hpp"
+
+#include <charconv>
+#include <cmath>
+
+namespace ast {
+	EmitFormat emit_format(std::string_view name) {
+		if(name == "text")
+			return Emit_Text;
+		if(name == "json")
+			return Emit_Json;
+		if(name == "sexpr")
+			return Emit_Sexpr;
+		return Emit_None;
+	}
+
+	Emitter::Emitter(std::ostream& out, EmitFormat format, const mist::Interner& names) :
+		out(out), format(format), names(names) {
+		buffer.reserve(Capacity + 1024);
+	}
+
+	Emitter::~Emitter() {
+		flush();
+	}
+
+	void Emitter::flush() {
+		out.write(buffer.data(), (std::streamsize) buffer.size());
+		out.flush();
+		buffer.clear();
+	}
+
+	void Emitter::emit(Module* module) {
+		begin_node("Module");
+		key("file");
+		string(module->file->name());
+		auto& decls = module->toplevelDeclarations;
+		field("decls", mist::Span<Decl*>(decls.data(), (u32) decls.size()));
+		end_node();
+		if(format != Emit_Text)
+			put('\n');
+		first = true;
+	}
+
+	Walk Emitter::enter_expr(Expr* expr) {
+		begin_node(expr->name(), expr->p);
+		return Prune;
+	}
+
+	Walk Emitter::enter_value(ValueExpr* e) {
+		enter_expr(e);
+		field("name", e->name);
+		field("generics", e->genericValues);
+		return Prune;
+	}
+
+	Walk Emitter::enter_tuple(TupleExpr* e) {
+		enter_expr(e);
+		field("values", e->values);
+		return Prune;
+	}
+
+	Walk Emitter::enter_integer_const(IntegerConstExpr* e) {
+		enter_expr(e);
+		key("value");
+		integer(e->value);
+		return Prune;
+	}
+
+	Walk Emitter::enter_float_const(FloatConstExpr* e) {
+		enter_expr(e);
+		key("value");
+		floating(e->value);
+		return Prune;
+	}
+
+	Walk Emitter::enter_string_const(StringConstExpr* e) {
+		enter_expr(e);
+		key("value");
+		string(e->value->val);
+		return Prune;
+	}
+
+	Walk Emitter::enter_boolean_const(BooleanConstExpr* e) {
+		enter_expr(e);
+		key("value");
+		boolean(e->value);
+		return Prune;
+	}
+
+	Walk Emitter::enter_char_const(CharConstExpr* e) {
+		enter_expr(e);
+		key("value");
+		string(std::string_view(&e->value, 1));
+		return Prune;
+	}
+
+	Walk Emitter::enter_binary(BinaryExpr* e) {
+		enter_expr(e);
+		key("op");
+		name(mist::Token::get_string((mist::TokenKind) (mist::Tkn_Plus + e->op)));
+		field("lhs", e->lhs);
+		field("rhs", e->rhs);
+		return Prune;
+	}
+
+	Walk Emitter::enter_unary(UnaryExpr* e) {
+		enter_expr(e);
+		key("op");
+		name(mist::Token::get_string(ast::from_unary(e->op)));
+		field("operand", e->expr);
+		return Prune;
+	}
+
+	Walk Emitter::enter_if(IfExpr* e) {
+		enter_expr(e);
+		field("cond", e->cond);
+		field("body", e->body);
+		return Prune;
+	}
+
+	Walk Emitter::enter_while(WhileExpr* e) {
+		enter_expr(e);
+		field("cond", e->cond);
+		field("body", e->body);
+		return Prune;
+	}
+
+	Walk Emitter::enter_loop(LoopExpr* e) {
+		enter_expr(e);
+		field("body", e->body);
+		return Prune;
+	}
+
+	Walk Emitter::enter_for(ForExpr* e) {
+		enter_expr(e);
+		field("index", e->index);
+		field("expr", e->expr);
+		field("body", e->body);
+		return Prune;
+	}
+
+	Walk Emitter::enter_match(MatchExpr* e) {
+		enter_expr(e);
+		field("cond", e->cond);
+		field("arms", e->arms);
+		return Prune;
+	}
+
+	Walk Emitter::enter_decl_expr(DeclExpr* e) {
+		enter_expr(e);
+		field("decl", e->decl);
+		return Prune;
+	}
+
+	Walk Emitter::enter_parenthesis(ParenthesisExpr* e) {
+		enter_expr(e);
+		field("operand", e->operand);
+		field("params", e->params);
+		return Prune;
+	}
+
+	Walk Emitter::enter_selector(SelectorExpr* e) {
+		enter_expr(e);
+		field("operand", e->operand);
+		field("element", e->element);
+		return Prune;
+	}
+
+	Walk Emitter::enter_return(ReturnExpr* e) {
+		enter_expr(e);
+		field("returns", e->returns);
+		return Prune;
+	}
+
+	Walk Emitter::enter_cast(CastExpr* e) {
+		enter_expr(e);
+		field("expr", e->expr);
+		field("type", e->ty);
+		return Prune;
+	}
+
+	Walk Emitter::enter_range(RangeExpr* e) {
+		enter_expr(e);
+		field("low", e->low);
+		field("high", e->high);
+		field("count", e->count);
+		return Prune;
+	}
+
+	Walk Emitter::enter_slice(SliceExpr* e) {
+		enter_expr(e);
+		field("low", e->low);
+		field("high", e->high);
+		return Prune;
+	}
+
+	Walk Emitter::enter_tuple_index(TupleIndexExpr* e) {
+		enter_expr(e);
+		field("operand", e->operand);
+		key("index");
+		integer(e->index);
+		return Prune;
+	}
+
+	Walk Emitter::enter_assignment(AssignmentExpr* e) {
+		enter_expr(e);
+		key("op");
+		name(mist::Token::get_string((mist::TokenKind) (mist::Tkn_Equal + e->op)));
+		field("lvalues", e->lvalues);
+		field("expr", e->expr);
+		return Prune;
+	}
+
+	Walk Emitter::enter_block(BlockExpr* e) {
+		enter_expr(e);
+		field("elements", e->elements);
+		return Prune;
+	}
+
+	Walk Emitter::enter_binding(BindingExpr* e) {
+		enter_expr(e);
+		field("name", e->name);
+		field("expr", e->expr);
+		return Prune;
+	}
+
+	// every declaration starts with its visibility and name.
+	Walk Emitter::enter_decl(Decl* decl) {
+		begin_node(decl->string(), decl->pos);
+		if(decl->vis == Public) {
+			key("public");
+			boolean(true);
+		}
+		field("name", decl->name);
+		return Prune;
+	}
+
+	Walk Emitter::enter_local(LocalDecl* d) {
+		enter_decl(d);
+		if(d->is_self) {
+			key("self");
+			boolean(true);
+		}
+		field("type", d->sp);
+		field("init", d->init);
+		return Prune;
+	}
+
+	Walk Emitter::enter_multi_local(MultiLocalDecl* d) {
+		enter_decl(d);
+		field("names", d->names);
+		field("types", d->sps);
+		field("inits", d->inits);
+		return Prune;
+	}
+
+	Walk Emitter::enter_struct(StructDecl* d) {
+		enter_decl(d);
+		walk(d->generics);
+		field("fields", d->fields);
+		field("derives", d->derives);
+		walk(d->where);
+		return Prune;
+	}
+
+	Walk Emitter::enter_typeclass(TypeClassDecl* d) {
+		enter_decl(d);
+		walk(d->generics);
+		field("members", d->members);
+		return Prune;
+	}
+
+	Walk Emitter::enter_function(FunctionDecl* d) {
+		enter_decl(d);
+		walk(d->generics);
+		field("params", d->parameters);
+		field("returns", d->returns);
+		field("body", d->body());
+		return Prune;
+	}
+
+	Walk Emitter::enter_op_function(OpFunctionDecl* d) {
+		enter_decl(d);
+		key("op");
+		if(d->op == OpParenthesis)
+			name("()");
+		else
+			name(d->op < OpParenthesis ? mist::Token::get_string((mist::TokenKind) (mist::Tkn_Plus + d->op)) : "?");
+		walk(d->generics);
+		field("params", d->parameters);
+		field("returns", d->returns);
+		field("body", d->body());
+		return Prune;
+	}
+
+	Walk Emitter::enter_use(UseDecl* d) {
+		enter_decl(d);
+		field("path", d->path);
+		field("fields", d->fields);
+		return Prune;
+	}
+
+	Walk Emitter::enter_impl(ImplDecl* d) {
+		enter_decl(d);
+		walk(d->generics);
+		field("methods", d->methods);
+		return Prune;
+	}
+
+	Walk Emitter::enter_generic(GenericDecl* d) {
+		enter_decl(d);
+		field("bounds", d->bounds);
+		return Prune;
+	}
+
+	Walk Emitter::enter_enum(EnumDecl* d) {
+		enter_decl(d);
+		walk(d->generics);
+		field("members", d->members);
+		return Prune;
+	}
+
+	Walk Emitter::enter_enum_member(EnumMemberDecl* d) {
+		enter_decl(d);
+		field("types", d->types);
+		field("init", d->init);
+		return Prune;
+	}
+
+	Walk Emitter::enter_spec(TypeSpec* spec) {
+		begin_node(spec->name(), spec->p);
+		return Prune;
+	}
+
+	Walk Emitter::enter_named_spec(NamedSpec* s) {
+		enter_spec(s);
+		field("name", s->name);
+		if(s->params)
+			field("params", s->params->exprs);
+		return Prune;
+	}
+
+	Walk Emitter::enter_tuple_spec(TupleSpec* s) {
+		enter_spec(s);
+		field("types", s->types);
+		return Prune;
+	}
+
+	Walk Emitter::enter_function_spec(FunctionSpec* s) {
+		enter_spec(s);
+		field("params", s->parameters);
+		field("returns", s->returns);
+		return Prune;
+	}
+
+	Walk Emitter::enter_typeclass_spec(TypeClassSpec* s) {
+		enter_spec(s);
+		field("name", s->name);
+		return Prune;
+	}
+
+	Walk Emitter::enter_array_spec(ArraySpec* s) {
+		enter_spec(s);
+		field("element", s->base);
+		field("size", s->size);
+		return Prune;
+	}
+
+	Walk Emitter::enter_dynamic_array_spec(DynamicArraySpec* s) {
+		enter_spec(s);
+		field("element", s->base);
+		return Prune;
+	}
+
+	Walk Emitter::enter_map_spec(MapSpec* s) {
+		enter_spec(s);
+		field("key", s->key);
+		field("value", s->value);
+		return Prune;
+	}
+
+	Walk Emitter::enter_path_spec(PathSpec* s) {
+		enter_spec(s);
+		field("path", s->path);
+		return Prune;
+	}
+
+	// a pointer, reference or constant of its base.
+	Walk Emitter::indirect(TypeSpec* spec) {
+		enter_spec(spec);
+		field("base", spec->base);
+		return Prune;
+	}
+
+	Walk Emitter::enter_generics(Generics* generics) {
+		field("generics", generics->parameters);
+		return Prune;
+	}
+
+	Walk Emitter::enter_where(WhereClause*) {
+		key("where");
+		begin_list();
+		return Recurse;
+	}
+
+	Walk Emitter::enter_where_element(WhereElement* element) {
+		begin_node("WhereElement", element->pos);
+		field("parameter", element->parameter);
+		field("types", element->type);
+		return Prune;
+	}
+
+	Walk Emitter::enter_path(UsePath* path) {
+		scratch.clear();
+		for(auto ident : path->names) {
+			if(!scratch.empty())
+				scratch.push_back('.');
+			scratch.append(names.get(ident->value));
+		}
+		name(scratch);
+		return Prune;
+	}
+
+	Walk Emitter::enter_match_arm(MatchArm* arm) {
+		begin_node("MatchArm");
+		field("name", arm->name);
+		field("value", arm->value);
+		field("body", arm->body);
+		return Prune;
+	}
+
+	void Emitter::begin_node(const char* kind) {
+		separate();
+		switch(format) {
+			case Emit_Json:
+				put("{\"node\":");
+				quote(kind);
+				break;
+			case Emit_Sexpr:
+				put('(');
+				put(kind);
+				break;
+			default:
+				put(kind);
+				put('\n');
+				++depth;
+				break;
+		}
+	}
+
+	void Emitter::begin_node(const char* kind, mist::Pos pos) {
+		separate();
+		char digits[32];
+		auto offset = std::to_chars(digits, digits + sizeof(digits), pos.offset).ptr;
+		auto span = std::to_chars(offset + 1, digits + sizeof(digits), pos.span).ptr;
+		switch(format) {
+			case Emit_Json:
+				*offset = ',';
+				put("{\"node\":");
+				quote(kind);
+				put(",\"pos\":[");
+				put(std::string_view(digits, span - digits));
+				put(']');
+				break;
+			case Emit_Sexpr:
+				*offset = ' ';
+				put('(');
+				put(kind);
+				put(" :pos (");
+				put(std::string_view(digits, span - digits));
+				put(')');
+				break;
+			default:
+				*offset = '+';
+				put(kind);
+				put(" @");
+				put(std::string_view(digits, span - digits));
+				put('\n');
+				++depth;
+				break;
+		}
+	}
+
+	void Emitter::end_node() {
+		switch(format) {
+			case Emit_Json: put('}'); break;
+			case Emit_Sexpr: put(')'); break;
+			default: --depth; break;
+		}
+		first = false;
+		if(buffer.size() >= Capacity)
+			flush();
+	}
+
+	void Emitter::begin_list() {
+		switch(format) {
+			case Emit_Json:
+				separate();
+				put('[');
+				break;
+			case Emit_Sexpr:
+				separate();
+				put('(');
+				break;
+			default:
+				// the elements go on the lines after the field name.
+				put('\n');
+				inlined = false;
+				++depth;
+				break;
+		}
+		first = true;
+	}
+
+	void Emitter::end_list() {
+		switch(format) {
+			case Emit_Json: put(']'); break;
+			case Emit_Sexpr: put(')'); break;
+			default: --depth; break;
+		}
+		first = false;
+	}
+
+	void Emitter::key(const char* key) {
+		switch(format) {
+			case Emit_Json:
+				separate();
+				quote(key);
+				put(':');
+				// the value follows the colon without a comma.
+				first = true;
+				break;
+			case Emit_Sexpr:
+				separate();
+				put(':');
+				put(key);
+				break;
+			default:
+				buffer.append(depth * 2, ' ');
+				put(key);
+				put(':');
+				inlined = true;
+				break;
+		}
+	}
+
+	void Emitter::name(std::string_view value) {
+		separate();
+		if(format == Emit_Text) {
+			put(value);
+			put('\n');
+		}
+		else
+			quote(value);
+	}
+
+	void Emitter::string(std::string_view value) {
+		separate();
+		quote(value);
+		if(format == Emit_Text)
+			put('\n');
+	}
+
+	void Emitter::integer(i64 value) {
+		separate();
+		char digits[24];
+		auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+		put(std::string_view(digits, end - digits));
+		if(format == Emit_Text)
+			put('\n');
+	}
+
+	void Emitter::floating(f64 value) {
+		separate();
+		char digits[32];
+		auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+		// json has no inf or nan, they are written as the strings "inf", "-inf" and "nan".
+		if(format == Emit_Json && !std::isfinite(value))
+			quote(std::string_view(digits, end - digits));
+		else
+			put(std::string_view(digits, end - digits));
+		if(format == Emit_Text)
+			put('\n');
+	}
+
+	void Emitter::boolean(bool value) {
+		separate();
+		put(value ? "true" : "false");
+		if(format == Emit_Text)
+			put('\n');
+	}
+
+	// what comes between the last thing written and the next value.
+	void Emitter::separate() {
+		switch(format) {
+			case Emit_Json:
+				if(!first)
+					put(',');
+				break;
+			case Emit_Sexpr:
+				if(!first)
+					put(' ');
+				break;
+			default:
+				if(inlined)
+					put(' ');
+				else
+					buffer.append(depth * 2, ' ');
+				inlined = false;
+				break;
+		}
+		first = false;
+	}
+
+	// a string in double quotes, escaped the way json reads it.
+	void Emitter::quote(std::string_view value) {
+		static const char hex[] = "0123456789abcdef";
+		put('"');
+		for(char c : value) {
+			switch(c) {
+				case '"': put("\\\""); break;
+				case '\\': put("\\\\"); break;
+				case '\n': put("\\n"); break;
+				case '\t': put("\\t"); break;
+				case '\r': put("\\r"); break;
+				default:
+					if((u8) c < 0x20) {
+						put("\\u00");
+						put(hex[(u8) c >> 4]);
+						put(hex[c & 0xf]);
+					}
+					else
+						put(c);
+					break;
+			}
+		}
+		put('"');
+	}
+}
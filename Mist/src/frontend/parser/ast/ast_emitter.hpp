@@ -0,0 +1,165 @@
+#pragma once
+
+#include "ast_common.hpp"
+#include "ast_decl.hpp"
+#include "ast_expr.hpp"
+#include "ast_typespec.hpp"
+#include "ast_visitor.hpp"
+#include "utils/interner.hpp"
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace ast {
+	enum EmitFormat : u8 {
+		Emit_None,
+		Emit_Text,		// indented, one field per line
+		Emit_Json,		// compact, a node is an object with its kind in "node"
+		Emit_Sexpr		// (Kind :field value ...)
+	};
+
+	/// the format named text, json or sexpr, Emit_None for anything else.
+	EmitFormat emit_format(std::string_view name);
+
+	/// Writes the ast in one of the formats. Everything goes through one
+	/// buffer that is handed to the stream each time it fills, it is reused
+	/// for every module emitted with the same Emitter.
+	///
+	/// It is an ast::Visitor, entering a node writes the node and its fields
+	/// and prunes, each field walks the child it holds. Leaving the node
+	/// closes it.
+	class Emitter : private Visitor<Emitter> {
+		public:
+			Emitter(std::ostream& out, EmitFormat format, const mist::Interner& names);
+			~Emitter();
+
+			void emit(Module* module);
+
+			/// writes out what is buffered.
+			void flush();
+
+		private:
+			friend class Visitor<Emitter>;
+
+			static const u32 Capacity = 1 << 16;
+
+			std::ostream& out;
+			EmitFormat format;
+			const mist::Interner& names;
+			std::string buffer;
+			std::string scratch;	// a dotted path being joined
+			u32 depth{0};			// nesting of the text format
+			bool first{true};		// nothing is written yet in the innermost node or list
+			bool inlined{false};	// a text field name was written, its value goes on the same line
+
+			// a node without fields of its own, the others write theirs after it.
+			Walk enter_expr(Expr* expr);
+			Walk enter_decl(Decl* decl);
+			Walk enter_spec(TypeSpec* spec);
+			bool leave_expr(Expr*) { end_node(); return true; }
+			bool leave_decl(Decl*) { end_node(); return true; }
+			bool leave_spec(TypeSpec*) { end_node(); return true; }
+
+			Walk enter_value(ValueExpr* e);
+			Walk enter_tuple(TupleExpr* e);
+			Walk enter_integer_const(IntegerConstExpr* e);
+			Walk enter_float_const(FloatConstExpr* e);
+			Walk enter_string_const(StringConstExpr* e);
+			Walk enter_boolean_const(BooleanConstExpr* e);
+			Walk enter_char_const(CharConstExpr* e);
+			Walk enter_binary(BinaryExpr* e);
+			Walk enter_unary(UnaryExpr* e);
+			Walk enter_if(IfExpr* e);
+			Walk enter_while(WhileExpr* e);
+			Walk enter_loop(LoopExpr* e);
+			Walk enter_for(ForExpr* e);
+			Walk enter_match(MatchExpr* e);
+			Walk enter_decl_expr(DeclExpr* e);
+			Walk enter_parenthesis(ParenthesisExpr* e);
+			Walk enter_selector(SelectorExpr* e);
+			Walk enter_return(ReturnExpr* e);
+			Walk enter_cast(CastExpr* e);
+			Walk enter_range(RangeExpr* e);
+			Walk enter_slice(SliceExpr* e);
+			Walk enter_tuple_index(TupleIndexExpr* e);
+			Walk enter_assignment(AssignmentExpr* e);
+			Walk enter_block(BlockExpr* e);
+			Walk enter_binding(BindingExpr* e);
+
+			Walk enter_local(LocalDecl* d);
+			Walk enter_multi_local(MultiLocalDecl* d);
+			Walk enter_struct(StructDecl* d);
+			Walk enter_typeclass(TypeClassDecl* d);
+			Walk enter_function(FunctionDecl* d);
+			Walk enter_op_function(OpFunctionDecl* d);
+			Walk enter_use(UseDecl* d);
+			Walk enter_impl(ImplDecl* d);
+			Walk enter_generic(GenericDecl* d);
+			Walk enter_enum(EnumDecl* d);
+			Walk enter_enum_member(EnumMemberDecl* d);
+
+			Walk enter_named_spec(NamedSpec* s);
+			Walk enter_tuple_spec(TupleSpec* s);
+			Walk enter_function_spec(FunctionSpec* s);
+			Walk enter_typeclass_spec(TypeClassSpec* s);
+			Walk enter_array_spec(ArraySpec* s);
+			Walk enter_dynamic_array_spec(DynamicArraySpec* s);
+			Walk enter_map_spec(MapSpec* s);
+			Walk enter_pointer_spec(PointerSpec* s) { return indirect(s); }
+			Walk enter_reference_spec(ReferenceSpec* s) { return indirect(s); }
+			Walk enter_constant_spec(ConstantSpec* s) { return indirect(s); }
+			Walk enter_path_spec(PathSpec* s);
+			Walk indirect(TypeSpec* spec);
+
+			// a where clause is a list of elements, a path is one dotted name.
+			Walk enter_generics(Generics* generics);
+			Walk enter_where(WhereClause* where);
+			bool leave_where(WhereClause*) { end_list(); return true; }
+			Walk enter_where_element(WhereElement* element);
+			bool leave_where_element(WhereElement*) { end_node(); return true; }
+			Walk enter_path(UsePath* path);
+			Walk enter_match_arm(MatchArm* arm);
+			bool leave_match_arm(MatchArm*) { end_node(); return true; }
+
+			// children are left out when they are null or empty.
+			template <typename T>
+			void field(const char* key, T* node) { if(node) { this->key(key); walk(node); } }
+			void field(const char* key, Ident* ident) { if(ident) { this->key(key); name(names.get(ident->value)); } }
+
+			template <typename T>
+			void field(const char* key, const mist::Span<T>& elements) {
+				if(elements.empty())
+					return;
+				this->key(key);
+				begin_list();
+				for(auto element : elements)
+					item(element);
+				end_list();
+			}
+
+			template <typename T>
+			void item(T* node) { walk(node); }
+			void item(Ident* ident) { name(names.get(ident->value)); }
+
+			// the structure every format is written with.
+			void begin_node(const char* kind);
+			void begin_node(const char* kind, mist::Pos pos);
+			void end_node();
+			void begin_list();
+			void end_list();
+			void key(const char* key);
+
+			// a name is bare in the text format, a string is always quoted.
+			void name(std::string_view value);
+			void string(std::string_view value);
+			void integer(i64 value);
+			void floating(f64 value);
+			void boolean(bool value);
+
+			void separate();
+			void quote(std::string_view value);
+			void put(std::string_view text) { buffer.append(text); }
+			void put(char c) { buffer.push_back(c); }
+	};
+}
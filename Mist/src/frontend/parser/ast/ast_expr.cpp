@@ -5,7 +5,7 @@
 
 namespace ast {
 
-	const static std::vector<std::string> expr_strings = {
+	static constexpr const char* expr_strings[] = {
 		ToString(Value),
 		ToString(Tuple),
 		ToString(IntegerConst),
@@ -78,15 +78,15 @@ namespace ast {
 	
 	mist::Pos Expr::pos() { return p; }
 
-	const std::string& Expr::name() {
+	const char* Expr::name() {
 		return expr_strings[k];
 	}
 
 	Expr::Expr(ExprKind k, mist::Pos p) : k(k), p(p) {}
 
-	ValueExpr::ValueExpr(Ident* name, const std::vector<Expr*>& generics, mist::Pos pos) : Expr(Value, pos), name(name), genericValues(generics) {}
+	ValueExpr::ValueExpr(Ident* name, mist::Span<Expr*> generics, mist::Pos pos) : Expr(Value, pos), name(name), genericValues(generics) {}
 	
-	TupleExpr::TupleExpr(const std::vector<Expr*>& values, mist::Pos pos) : Expr(Tuple, pos), values(values) {
+	TupleExpr::TupleExpr(mist::Span<Expr*> values, mist::Pos pos) : Expr(Tuple, pos), values(values) {
 
 	}
 	
@@ -96,7 +96,7 @@ namespace ast {
 	FloatConstExpr::FloatConstExpr(f64 val, ConstantType cty, mist::Pos pos) : Expr(FloatConst, pos),
 		value(val), cty(cty) {	}
 	
-	StringConstExpr::StringConstExpr(const std::string& val, mist::Pos pos) : Expr(StringConst, pos), value(val) {
+	StringConstExpr::StringConstExpr(mist::String* val, mist::Pos pos) : Expr(StringConst, pos), value(val) {
 	}
 	
 	BooleanConstExpr::BooleanConstExpr(bool val, mist::Pos pos) : Expr(BooleanConst, pos), value(val) {
@@ -126,13 +126,13 @@ namespace ast {
 	MatchArm::MatchArm(Expr* name, Ident* value, Expr* body) : name(name), value(value), body(body) {
 	}
 	
-	MatchExpr::MatchExpr(Expr* cond, const std::vector<MatchArm*>& arms, mist::Pos pos) : Expr(Match, pos), cond(cond), arms(arms) {
+	MatchExpr::MatchExpr(Expr* cond, mist::Span<MatchArm*> arms, mist::Pos pos) : Expr(Match, pos), cond(cond), arms(arms) {
 	}
 	
 	DeclExpr::DeclExpr(Decl* decl) : Expr(ExprKind::DeclDecl, decl->pos), decl(decl) {
 	}
 	
-	ParenthesisExpr::ParenthesisExpr(Expr* operand, const std::vector<Expr*>& params, mist::Pos pos) : Expr(Parenthesis, pos), operand(operand), params(params){
+	ParenthesisExpr::ParenthesisExpr(Expr* operand, mist::Span<Expr*> params, mist::Pos pos) : Expr(Parenthesis, pos), operand(operand), params(params){
 	}
 	
 	SelectorExpr::SelectorExpr(Expr* operand, ValueExpr* element, mist::Pos pos) : Expr(Selector, pos), operand(operand), element(element) {
@@ -144,7 +144,7 @@ namespace ast {
 	ContinueExpr::ContinueExpr(mist::Pos pos) : Expr(Continue, pos) {
 	}
 	
-	ReturnExpr::ReturnExpr(const std::vector<Expr*> returns, mist::Pos pos) : Expr(Return, pos), returns(returns) {
+	ReturnExpr::ReturnExpr(mist::Span<Expr*> returns, mist::Pos pos) : Expr(Return, pos), returns(returns) {
 	}
 	
 	CastExpr::CastExpr(Expr* expr, TypeSpec* ty, mist::Pos pos) : Expr(Cast, pos), expr(expr), ty(ty) {
@@ -159,10 +159,10 @@ namespace ast {
 	TupleIndexExpr::TupleIndexExpr(Expr* operand, i32 index, mist::Pos pos) : Expr(TupleIndex, pos), operand(operand), index(index) {
 	}
 	
-	AssignmentExpr::AssignmentExpr(AssignmentOp op, const std::vector<Expr*> lvalues, Expr* expr, mist::Pos pos) : Expr(Assignment, pos), op(op), lvalues(lvalues), expr(expr) {
+	AssignmentExpr::AssignmentExpr(AssignmentOp op, mist::Span<Expr*> lvalues, Expr* expr, mist::Pos pos) : Expr(Assignment, pos), op(op), lvalues(lvalues), expr(expr) {
 	}
 	
-	BlockExpr::BlockExpr(const std::vector<Expr*> elements, mist::Pos pos) : Expr(Block, pos), elements(elements) {
+	BlockExpr::BlockExpr(mist::Span<Expr*> elements, mist::Pos pos) : Expr(Block, pos), elements(elements) {
 	}
 	
 	BindingExpr::BindingExpr(ast::Ident* name, Expr* expr, mist::Pos pos) : Expr(Binding, pos), name(name), expr(expr) {
@@ -124,20 +124,20 @@ namespace ast {
 		Type* type();
 		mist::Pos pos();
 
-		const std::string& name();
+		const char* name();
 	};
 
 	struct ValueExpr : public Expr {
 		Ident* name;
-		std::vector<Expr*> genericValues;
+		mist::Span<Expr*> genericValues;
 
-		ValueExpr(Ident* name, const std::vector<Expr*>& generics, mist::Pos pos);
+		ValueExpr(Ident* name, mist::Span<Expr*> generics, mist::Pos pos);
 	};
 
 	struct TupleExpr : public Expr {
-		std::vector<Expr*> values;
+		mist::Span<Expr*> values;
 
-		TupleExpr(const std::vector<Expr*>& values, mist::Pos pos);
+		TupleExpr(mist::Span<Expr*> values, mist::Pos pos);
 	};
 
 	struct IntegerConstExpr : public Expr {
@@ -155,9 +155,9 @@ namespace ast {
 	};
 
 	struct StringConstExpr : public Expr {
-		std::string value;
+		mist::String* value;		// decoded literal, owned by the literal pool
 
-		StringConstExpr(const std::string& val, mist::Pos pos);
+		StringConstExpr(mist::String* val, mist::Pos pos);
 	};
 
 	struct BooleanConstExpr : public Expr {
@@ -225,9 +225,9 @@ namespace ast {
 
 	struct MatchExpr : public Expr {
 		Expr* cond;
-		std::vector<MatchArm*> arms;
+		mist::Span<MatchArm*> arms;
 
-		MatchExpr(Expr* cond, const std::vector<MatchArm*>& arms, mist::Pos pos);
+		MatchExpr(Expr* cond, mist::Span<MatchArm*> arms, mist::Pos pos);
 	};
 
 	struct DeclExpr : public Expr {
@@ -238,8 +238,8 @@ namespace ast {
 
 	struct ParenthesisExpr : public Expr {
 		Expr* operand;
-		std::vector<Expr*> params;
-		ParenthesisExpr(Expr* operand, const std::vector<Expr*>& params, mist::Pos pos);
+		mist::Span<Expr*> params;
+		ParenthesisExpr(Expr* operand, mist::Span<Expr*> params, mist::Pos pos);
 	};
 
 	struct SelectorExpr : public Expr {
@@ -258,9 +258,9 @@ namespace ast {
 	};
 
 	struct ReturnExpr : public Expr {
-		std::vector<Expr*> returns;
+		mist::Span<Expr*> returns;
 
-		ReturnExpr(const std::vector<Expr*> returns, mist::Pos pos);
+		ReturnExpr(mist::Span<Expr*> returns, mist::Pos pos);
 	};
 
 	struct CastExpr : public Expr {
@@ -295,16 +295,16 @@ namespace ast {
 
 	struct AssignmentExpr : public Expr {
 		AssignmentOp op;
-		std::vector<Expr*> lvalues;
+		mist::Span<Expr*> lvalues;
 		Expr* expr;
 
-		AssignmentExpr(AssignmentOp op, const std::vector<Expr*> lvalues, Expr* expr, mist::Pos pos);
+		AssignmentExpr(AssignmentOp op, mist::Span<Expr*> lvalues, Expr* expr, mist::Pos pos);
 	};
 
 	struct BlockExpr : public Expr {
-		std::vector<Expr*> elements;
+		mist::Span<Expr*> elements;
 
-		BlockExpr(const std::vector<Expr*> elements, mist::Pos pos);
+		BlockExpr(mist::Span<Expr*> elements, mist::Pos pos);
 	};
 
 	struct BindingExpr : public Expr {
@@ -0,0 +1,756 @@
+#include "ast_flat.hpp"
+#include "interpreter.hpp"
+
+#include <cstring>
+
+#define CAST(T, e) static_cast<T*>(e)
+
+namespace ast {
+	namespace {
+		inline u32 low(u64 value) { return (u32) value; }
+		inline u32 high(u64 value) { return (u32) (value >> 32); }
+
+		struct Flattener {
+			FlatTree& tree;
+
+			Flattener(FlatTree& tree) : tree(tree) {
+				// handle 0 and extra[0] are the empty node and the empty list.
+				push(Node_None, mist::Pos());
+				tree.extra.push_back(0);
+			}
+
+			u32 push(NodeTag tag, mist::Pos pos, u32 a = 0, u32 b = 0, u32 c = 0, u8 sub = 0, u16 flags = 0) {
+				tree.nodes.push_back(Node{tag, sub, flags, a, b, c});
+				tree.positions.push_back(pos);
+				return (u32) tree.nodes.size() - 1;
+			}
+
+			// the children are flattened before the list is written, their
+			// own lists end up in extra first.
+			template <typename T, typename F>
+			u32 list(const mist::Span<T>& elements, F each) {
+				if(elements.empty())
+					return 0;
+				std::vector<u32> handles;
+				handles.reserve(elements.size());
+				for(auto element : elements)
+					handles.push_back(each(element));
+
+				u32 index = (u32) tree.extra.size();
+				tree.extra.push_back((u32) handles.size());
+				tree.extra.insert(tree.extra.end(), handles.begin(), handles.end());
+				return index;
+			}
+
+			u32 record(std::initializer_list<u32> fields) {
+				u32 index = (u32) tree.extra.size();
+				tree.extra.insert(tree.extra.end(), fields);
+				return index;
+			}
+
+			u32 exprs(const mist::Span<Expr*>& elements) {
+				return list(elements, [this](Expr* e) { return expr(e); });
+			}
+
+			u32 specs(const mist::Span<TypeSpec*>& elements) {
+				return list(elements, [this](TypeSpec* s) { return spec(s); });
+			}
+
+			template <typename T>
+			u32 decls(const mist::Span<T*>& elements) {
+				return list(elements, [this](T* d) { return decl(d); });
+			}
+
+			u32 ident(Ident* ident) {
+				if(!ident)
+					return 0;
+				return push(Node_Ident, ident->pos, ident->value);
+			}
+
+			u32 path(UsePath* path) {
+				if(!path)
+					return 0;
+				u32 names = list(path->names, [this](Ident* i) { return ident(i); });
+				return push(Node_Path, path->pos, names);
+			}
+
+			u32 generics(Generics* generics) {
+				if(!generics)
+					return 0;
+				u32 parameters = decls(generics->parameters);
+				return push(Node_Generics, mist::Pos(), parameters);
+			}
+
+			// a body that is still skipped is not parsed just to be flattened.
+			u32 body(Expr* parsed, LazyBody* lazy) {
+				if(parsed || !lazy)
+					return expr(parsed);
+				return push(Node_LazyBody, mist::Pos(), lazy->begin, lazy->end, lazy->res);
+			}
+
+			u32 where(WhereClause* where) {
+				if(!where)
+					return 0;
+				u32 elements = list(where->elements, [this](WhereElement* e) {
+					u32 parameter = ident(e->parameter);
+					u32 types = specs(e->type);
+					return push(Node_WhereElement, e->pos, parameter, types);
+				});
+				return push(Node_Where, where->pos, elements);
+			}
+
+			u32 expr(Expr* expr) {
+				if(!expr)
+					return 0;
+				auto pos = expr->p;
+				switch(expr->k) {
+					case Value: {
+						auto e = CAST(ValueExpr, expr);
+						u32 name = ident(e->name);
+						return push(Node_Value, pos, name, exprs(e->genericValues));
+					}
+					case Tuple:
+						return push(Node_Tuple, pos, exprs(CAST(TupleExpr, expr)->values));
+					case IntegerConst: {
+						auto e = CAST(IntegerConstExpr, expr);
+						return push(Node_IntegerConst, pos, low((u64) e->value), high((u64) e->value), 0, (u8) e->cty);
+					}
+					case FloatConst: {
+						auto e = CAST(FloatConstExpr, expr);
+						u64 bits;
+						std::memcpy(&bits, &e->value, sizeof(bits));
+						return push(Node_FloatConst, pos, low(bits), high(bits), 0, (u8) e->cty);
+					}
+					case StringConst: {
+						auto& value = CAST(StringConstExpr, expr)->value->val;
+						u32 offset = (u32) tree.text.size();
+						tree.text.insert(tree.text.end(), value.begin(), value.end());
+						return push(Node_StringConst, pos, offset, (u32) value.size());
+					}
+					case BooleanConst:
+						return push(Node_BooleanConst, pos, CAST(BooleanConstExpr, expr)->value);
+					case CharConst:
+						return push(Node_CharConst, pos, (u8) CAST(CharConstExpr, expr)->value);
+					case Binary: {
+						auto e = CAST(BinaryExpr, expr);
+						u32 lhs = this->expr(e->lhs);
+						u32 rhs = this->expr(e->rhs);
+						return push(Node_Binary, pos, lhs, rhs, 0, (u8) e->op);
+					}
+					case Unary: {
+						auto e = CAST(UnaryExpr, expr);
+						return push(Node_Unary, pos, this->expr(e->expr), 0, 0, (u8) e->op);
+					}
+					case If: {
+						auto e = CAST(IfExpr, expr);
+						u32 cond = this->expr(e->cond);
+						return push(Node_If, pos, cond, this->expr(e->body));
+					}
+					case While: {
+						auto e = CAST(WhileExpr, expr);
+						u32 cond = this->expr(e->cond);
+						return push(Node_While, pos, cond, this->expr(e->body));
+					}
+					case Loop:
+						return push(Node_Loop, pos, this->expr(CAST(LoopExpr, expr)->body));
+					case For: {
+						auto e = CAST(ForExpr, expr);
+						u32 index = this->expr(e->index);
+						u32 iter = this->expr(e->expr);
+						return push(Node_For, pos, index, iter, this->expr(e->body));
+					}
+					case Match: {
+						auto e = CAST(MatchExpr, expr);
+						u32 cond = this->expr(e->cond);
+						u32 arms = list(e->arms, [this](MatchArm* arm) {
+							u32 name = this->expr(arm->name);
+							u32 value = ident(arm->value);
+							return push(Node_MatchArm, mist::Pos(), name, value, this->expr(arm->body));
+						});
+						return push(Node_Match, pos, cond, arms);
+					}
+					case DeclDecl:
+						return push(Node_DeclExpr, pos, decl(CAST(DeclExpr, expr)->decl));
+					case Parenthesis: {
+						auto e = CAST(ParenthesisExpr, expr);
+						u32 operand = this->expr(e->operand);
+						return push(Node_Parenthesis, pos, operand, exprs(e->params));
+					}
+					case Selector: {
+						auto e = CAST(SelectorExpr, expr);
+						u32 operand = this->expr(e->operand);
+						return push(Node_Selector, pos, operand, this->expr(e->element));
+					}
+					case Break:
+						return push(Node_Break, pos);
+					case Continue:
+						return push(Node_Continue, pos);
+					case Return:
+						return push(Node_Return, pos, exprs(CAST(ReturnExpr, expr)->returns));
+					case Cast: {
+						auto e = CAST(CastExpr, expr);
+						u32 value = this->expr(e->expr);
+						return push(Node_Cast, pos, value, spec(e->ty));
+					}
+					case Range: {
+						auto e = CAST(RangeExpr, expr);
+						u32 low = this->expr(e->low);
+						u32 high = this->expr(e->high);
+						return push(Node_Range, pos, low, high, this->expr(e->count));
+					}
+					case Slice: {
+						auto e = CAST(SliceExpr, expr);
+						u32 low = this->expr(e->low);
+						return push(Node_Slice, pos, low, this->expr(e->high));
+					}
+					case TupleIndex: {
+						auto e = CAST(TupleIndexExpr, expr);
+						return push(Node_TupleIndex, pos, this->expr(e->operand), (u32) e->index);
+					}
+					case Assignment: {
+						auto e = CAST(AssignmentExpr, expr);
+						u32 lvalues = exprs(e->lvalues);
+						return push(Node_Assignment, pos, lvalues, this->expr(e->expr), 0, (u8) e->op);
+					}
+					case Block:
+						return push(Node_Block, pos, exprs(CAST(BlockExpr, expr)->elements));
+					case Binding: {
+						auto e = CAST(BindingExpr, expr);
+						u32 name = ident(e->name);
+						return push(Node_Binding, pos, name, this->expr(e->expr));
+					}
+					case UnitLit:
+						return push(Node_UnitLit, pos);
+					case SelfLit:
+						return push(Node_SelfLit, pos);
+					default:
+						return 0;
+				}
+			}
+
+			u32 decl(Decl* decl) {
+				if(!decl)
+					return 0;
+				auto pos = decl->pos;
+				u16 flags = decl->vis == Public ? NodeFlag_Public : 0;
+				u32 name = ident(decl->name);
+				switch(decl->k) {
+					case Local: {
+						auto d = CAST(LocalDecl, decl);
+						u32 type = spec(d->sp);
+						u32 init = expr(d->init);
+						if(d->is_self)
+							flags |= NodeFlag_Self;
+						return push(Node_Local, pos, name, type, init, 0, flags);
+					}
+					case MultiLocal: {
+						auto d = CAST(MultiLocalDecl, decl);
+						u32 names = list(d->names, [this](Ident* i) { return ident(i); });
+						u32 types = specs(d->sps);
+						u32 inits = exprs(d->inits);
+						return push(Node_MultiLocal, pos, names, types, inits, 0, flags);
+					}
+					case Struct: {
+						auto d = CAST(StructDecl, decl);
+						u32 fields = decls(d->fields);
+						u32 derives = specs(d->derives);
+						u32 clause = where(d->where);
+						u32 params = generics(d->generics);
+						return push(Node_Struct, pos, name, record({fields, derives, clause, params}), 0, 0, flags);
+					}
+					case TypeClass: {
+						auto d = CAST(TypeClassDecl, decl);
+						u32 members = decls(d->members);
+						return push(Node_TypeClass, pos, name, members, generics(d->generics), 0, flags);
+					}
+					case Function: {
+						auto d = CAST(FunctionDecl, decl);
+						u32 params = decls(d->parameters);
+						u32 returns = specs(d->returns);
+						u32 body = this->body(d->parsed.load(std::memory_order_acquire), d->lazy);
+						u32 gens = generics(d->generics);
+						return push(Node_Function, pos, name, record({params, returns, body, gens}), 0, 0, flags);
+					}
+					case OpFunction: {
+						auto d = CAST(OpFunctionDecl, decl);
+						u32 params = decls(d->parameters);
+						u32 returns = specs(d->returns);
+						u32 body = this->body(d->parsed.load(std::memory_order_acquire), d->lazy);
+						u32 gens = generics(d->generics);
+						return push(Node_OpFunction, pos, name, record({params, returns, body, gens}), 0, (u8) d->op, flags);
+					}
+					case Use: {
+						auto d = CAST(UseDecl, decl);
+						u32 fields = list(d->fields, [this](UsePath* p) { return path(p); });
+						return push(Node_Use, pos, name, path(d->path), fields, 0, flags);
+					}
+					case Impl: {
+						auto d = CAST(ImplDecl, decl);
+						u32 methods = decls(d->methods);
+						return push(Node_Impl, pos, name, methods, generics(d->generics), 0, flags);
+					}
+					case Generic:
+						return push(Node_Generic, pos, name, specs(CAST(GenericDecl, decl)->bounds), 0, 0, flags);
+					case Enum: {
+						auto d = CAST(EnumDecl, decl);
+						u32 members = decls(d->members);
+						return push(Node_Enum, pos, name, members, generics(d->generics), 0, flags);
+					}
+					case EnumMember: {
+						auto d = CAST(EnumMemberDecl, decl);
+						u32 types = specs(d->types);
+						u32 init = expr(d->init);
+						return push(Node_EnumMember, pos, name, types, init, (u8) d->ekind, flags);
+					}
+					default:
+						return 0;
+				}
+			}
+
+			u32 spec(TypeSpec* spec) {
+				if(!spec)
+					return 0;
+				auto pos = spec->p;
+				switch(spec->k) {
+					case Named: {
+						auto s = CAST(NamedSpec, spec);
+						u32 name = ident(s->name);
+						if(!s->params)
+							return push(Node_NamedSpec, pos, name);
+						return push(Node_NamedSpec, pos, name, exprs(s->params->exprs), 0, 0, NodeFlag_Params);
+					}
+					case TupleType:
+						return push(Node_TupleSpec, pos, specs(CAST(TupleSpec, spec)->types));
+					case FunctionType: {
+						auto s = CAST(FunctionSpec, spec);
+						u32 parameters = specs(s->parameters);
+						return push(Node_FunctionSpec, pos, parameters, specs(s->returns));
+					}
+					case TypeClassType:
+						return push(Node_TypeClassSpec, pos, this->spec(CAST(TypeClassSpec, spec)->name));
+					case Array: {
+						auto s = CAST(ArraySpec, spec);
+						u32 element = this->spec(s->base);
+						return push(Node_ArraySpec, pos, element, expr(s->size));
+					}
+					case DynamicArray:
+						return push(Node_DynamicArraySpec, pos, this->spec(spec->base));
+					case Map: {
+						auto s = CAST(MapSpec, spec);
+						u32 key = this->spec(s->key);
+						return push(Node_MapSpec, pos, key, this->spec(s->value));
+					}
+					case Pointer:
+						return push(Node_PointerSpec, pos, this->spec(spec->base));
+					case Reference:
+						return push(Node_ReferenceSpec, pos, this->spec(spec->base));
+					case Constant:
+						return push(Node_ConstantSpec, pos, this->spec(spec->base));
+					case Path:
+						return push(Node_PathSpec, pos, list(CAST(PathSpec, spec)->path, [this](NamedSpec* s) { return this->spec(s); }));
+					case Unit:
+						return push(Node_UnitSpec, pos);
+					default:
+						return 0;
+				}
+			}
+		};
+
+		struct Expander {
+			const FlatView& tree;
+			Module* module;
+			mist::Interpreter* interp;
+			const std::vector<u32>& symbols;
+			i64 shift;
+
+			template <typename T, typename... Args>
+			T* make(Args&&... args) {
+				return module->arena.make<T>(std::forward<Args>(args)...);
+			}
+
+			mist::Pos pos(u32 handle) {
+				auto pos = tree.pos(handle);
+				if(pos.offset)
+					pos.offset = (u32) (pos.offset + shift);
+				return pos;
+			}
+
+			// the elements go straight into the arena, the length is known up front.
+			template <typename T, typename F>
+			mist::Span<T> list(u32 index, F each) {
+				auto handles = tree.list(index);
+				if(handles.empty())
+					return mist::Span<T>();
+				auto data = (T*) module->arena.alloc(sizeof(T) * handles.size(), alignof(T));
+				for(u32 i = 0; i < handles.size(); ++i)
+					data[i] = each(handles[i]);
+				return mist::Span<T>(data, handles.size());
+			}
+
+			mist::Span<Expr*> exprs(u32 index) {
+				return list<Expr*>(index, [this](u32 h) { return expr(h); });
+			}
+
+			mist::Span<TypeSpec*> specs(u32 index) {
+				return list<TypeSpec*>(index, [this](u32 h) { return spec(h); });
+			}
+
+			template <typename T>
+			mist::Span<T*> decls(u32 index) {
+				return list<T*>(index, [this](u32 h) { return static_cast<T*>(decl(h)); });
+			}
+
+			mist::Span<Ident*> idents(u32 index) {
+				return list<Ident*>(index, [this](u32 h) { return ident(h); });
+			}
+
+			Ident* ident(u32 handle) {
+				if(!handle)
+					return nullptr;
+				u32 value = tree.node(handle).a;
+				return make<Ident>(symbols.empty() ? value : symbols[value], pos(handle));
+			}
+
+			UsePath* path(u32 handle) {
+				if(!handle)
+					return nullptr;
+				return make<UsePath>(idents(tree.node(handle).a), pos(handle));
+			}
+
+			Generics* generics(u32 handle) {
+				if(!handle)
+					return nullptr;
+				return make<Generics>(decls<GenericDecl>(tree.node(handle).a));
+			}
+
+			WhereClause* where(u32 handle) {
+				if(!handle)
+					return nullptr;
+				auto elements = list<WhereElement*>(tree.node(handle).a, [this](u32 h) {
+					auto& n = tree.node(h);
+					return make<WhereElement>(ident(n.a), specs(n.b), pos(h));
+				});
+				return make<WhereClause>(elements, pos(handle));
+			}
+
+			// the body is parsed from the file like one the parser skipped.
+			LazyBody* lazy(u32 handle) {
+				if(tree.tag(handle) != Node_LazyBody)
+					return nullptr;
+				auto& n = tree.node(handle);
+				module->interp = interp;
+				return make<LazyBody>(module, n.a, n.b, n.c);
+			}
+
+			Expr* expr(u32 handle) {
+				if(!handle)
+					return nullptr;
+				auto& n = tree.node(handle);
+				auto p = pos(handle);
+				switch(n.tag) {
+					case Node_Value:
+						return make<ValueExpr>(ident(n.a), exprs(n.b), p);
+					case Node_Tuple:
+						return make<TupleExpr>(exprs(n.a), p);
+					case Node_IntegerConst:
+						return make<IntegerConstExpr>((i64) tree.integer(handle), (ConstantType) n.sub, p);
+					case Node_FloatConst:
+						return make<FloatConstExpr>(tree.floating(handle), (ConstantType) n.sub, p);
+					case Node_StringConst:
+						return make<StringConstExpr>(interp->find_literal(tree.string(handle)), p);
+					case Node_BooleanConst:
+						return make<BooleanConstExpr>(n.a != 0, p);
+					case Node_CharConst:
+						return make<CharConstExpr>((char) n.a, p);
+					case Node_Binary: {
+						auto lhs = expr(n.a);
+						return make<BinaryExpr>((BinaryOp) n.sub, lhs, expr(n.b), p);
+					}
+					case Node_Unary:
+						return make<UnaryExpr>((UnaryOp) n.sub, expr(n.a), p);
+					case Node_If: {
+						auto cond = expr(n.a);
+						return make<IfExpr>(cond, expr(n.b), p);
+					}
+					case Node_While: {
+						auto cond = expr(n.a);
+						return make<WhileExpr>(cond, expr(n.b), p);
+					}
+					case Node_Loop:
+						return make<LoopExpr>(expr(n.a), p);
+					case Node_For: {
+						auto index = expr(n.a);
+						auto iter = expr(n.b);
+						return make<ForExpr>(index, iter, expr(n.c), p);
+					}
+					case Node_Match: {
+						auto cond = expr(n.a);
+						auto arms = list<MatchArm*>(n.b, [this](u32 h) {
+							auto& arm = tree.node(h);
+							auto name = expr(arm.a);
+							auto value = ident(arm.b);
+							return make<MatchArm>(name, value, expr(arm.c));
+						});
+						return make<MatchExpr>(cond, arms, p);
+					}
+					case Node_DeclExpr: {
+						auto d = decl(n.a);
+						return d ? make<DeclExpr>(d) : nullptr;
+					}
+					case Node_Parenthesis: {
+						auto operand = expr(n.a);
+						return make<ParenthesisExpr>(operand, exprs(n.b), p);
+					}
+					case Node_Selector: {
+						auto operand = expr(n.a);
+						return make<SelectorExpr>(operand, static_cast<ValueExpr*>(expr(n.b)), p);
+					}
+					case Node_Break:
+						return make<BreakExpr>(p);
+					case Node_Continue:
+						return make<ContinueExpr>(p);
+					case Node_Return:
+						return make<ReturnExpr>(exprs(n.a), p);
+					case Node_Cast: {
+						auto value = expr(n.a);
+						return make<CastExpr>(value, spec(n.b), p);
+					}
+					case Node_Range: {
+						auto low = expr(n.a);
+						auto high = expr(n.b);
+						return make<RangeExpr>(low, high, expr(n.c), p);
+					}
+					case Node_Slice: {
+						auto low = expr(n.a);
+						return make<SliceExpr>(low, expr(n.b), p);
+					}
+					case Node_TupleIndex:
+						return make<TupleIndexExpr>(expr(n.a), (i32) n.b, p);
+					case Node_Assignment: {
+						auto lvalues = exprs(n.a);
+						return make<AssignmentExpr>((AssignmentOp) n.sub, lvalues, expr(n.b), p);
+					}
+					case Node_Block:
+						return make<BlockExpr>(exprs(n.a), p);
+					case Node_Binding: {
+						auto name = ident(n.a);
+						return make<BindingExpr>(name, expr(n.b), p);
+					}
+					case Node_UnitLit:
+						return make<UnitExpr>(p);
+					case Node_SelfLit:
+						return make<SelfExpr>(p);
+					default:
+						return nullptr;
+				}
+			}
+
+			Decl* decl(u32 handle) {
+				if(!handle)
+					return nullptr;
+				auto& n = tree.node(handle);
+				auto p = pos(handle);
+				Decl* d = nullptr;
+				switch(n.tag) {
+					case Node_Local: {
+						auto name = ident(n.a);
+						auto type = spec(n.b);
+						auto local = make<LocalDecl>(name, type, expr(n.c), p);
+						local->is_self = (n.flags & NodeFlag_Self) != 0;
+						d = local;
+						break;
+					}
+					case Node_MultiLocal: {
+						auto names = idents(n.a);
+						auto types = specs(n.b);
+						d = make<MultiLocalDecl>(names, types, exprs(n.c), p);
+						break;
+					}
+					case Node_Struct: {
+						auto name = ident(n.a);
+						auto fields = decls<FieldDecl>(tree.field(n.b, 0));
+						auto derives = specs(tree.field(n.b, 1));
+						auto clause = where(tree.field(n.b, 2));
+						d = make<StructDecl>(name, fields, derives, clause, generics(tree.field(n.b, 3)), p);
+						break;
+					}
+					case Node_TypeClass: {
+						auto name = ident(n.a);
+						auto members = decls<Decl>(n.b);
+						d = make<TypeClassDecl>(name, members, generics(n.c), p);
+						break;
+					}
+					case Node_Function:
+					case Node_OpFunction: {
+						auto name = ident(n.a);
+						auto params = decls<FieldDecl>(tree.field(n.b, 0));
+						auto returns = specs(tree.field(n.b, 1));
+						u32 handle = tree.field(n.b, 2);
+						auto body = tree.tag(handle) == Node_LazyBody ? nullptr : expr(handle);
+						auto gens = generics(tree.field(n.b, 3));
+						if(n.tag == Node_Function) {
+							auto f = make<FunctionDecl>(name, params, returns, body, gens, p);
+							f->lazy = lazy(handle);
+							d = f;
+						}
+						else {
+							auto f = make<OpFunctionDecl>((Op) n.sub, params, returns, body, gens, p);
+							f->lazy = lazy(handle);
+							d = f;
+						}
+						break;
+					}
+					case Node_Use: {
+						auto name = ident(n.a);
+						auto used = path(n.b);
+						d = make<UseDecl>(name, used, list<UsePath*>(n.c, [this](u32 h) { return path(h); }), p);
+						break;
+					}
+					case Node_Impl: {
+						auto name = ident(n.a);
+						auto methods = decls<FunctionDecl>(n.b);
+						d = make<ImplDecl>(name, methods, generics(n.c), p);
+						break;
+					}
+					case Node_Generic: {
+						auto name = ident(n.a);
+						d = make<GenericDecl>(name, specs(n.b), p);
+						break;
+					}
+					case Node_Enum: {
+						auto name = ident(n.a);
+						auto members = decls<EnumMemberDecl>(n.b);
+						d = make<EnumDecl>(name, members, generics(n.c), p);
+						break;
+					}
+					case Node_EnumMember: {
+						auto name = ident(n.a);
+						auto types = specs(n.b);
+						d = make<EnumMemberDecl>(name, (EnumDeclKind) n.sub, p, types, expr(n.c));
+						break;
+					}
+					default:
+						return nullptr;
+				}
+				if(n.flags & NodeFlag_Public)
+					d->vis = Public;
+				return d;
+			}
+
+			TypeSpec* spec(u32 handle) {
+				if(!handle)
+					return nullptr;
+				auto& n = tree.node(handle);
+				auto p = pos(handle);
+				switch(n.tag) {
+					case Node_NamedSpec: {
+						auto name = ident(n.a);
+						GenericParameters* params = nullptr;
+						if(n.flags & NodeFlag_Params)
+							params = make<GenericParameters>(exprs(n.b));
+						return make<NamedSpec>(name, params, p);
+					}
+					case Node_TupleSpec:
+						return make<TupleSpec>(specs(n.a), p);
+					case Node_FunctionSpec: {
+						auto parameters = specs(n.a);
+						return make<FunctionSpec>(parameters, specs(n.b), p);
+					}
+					case Node_TypeClassSpec:
+						return make<TypeClassSpec>(static_cast<NamedSpec*>(spec(n.a)), p);
+					case Node_ArraySpec: {
+						auto element = spec(n.a);
+						return make<ArraySpec>(element, static_cast<IntegerConstExpr*>(expr(n.b)), p);
+					}
+					case Node_DynamicArraySpec:
+						return make<DynamicArraySpec>(spec(n.a), p);
+					case Node_MapSpec: {
+						auto key = spec(n.a);
+						return make<MapSpec>(key, spec(n.b), p);
+					}
+					case Node_PointerSpec:
+						return make<PointerSpec>(spec(n.a), p);
+					case Node_ReferenceSpec:
+						return make<ReferenceSpec>(spec(n.a), p);
+					case Node_ConstantSpec:
+						return make<ConstantSpec>(spec(n.a), p);
+					case Node_PathSpec:
+						return make<PathSpec>(list<NamedSpec*>(n.a, [this](u32 h) { return static_cast<NamedSpec*>(spec(h)); }), p);
+					case Node_UnitSpec:
+						return make<UnitSpec>(p);
+					default:
+						return nullptr;
+				}
+			}
+		};
+	}
+
+	u64 FlatView::integer(u32 index) const {
+		auto& n = nodes[index];
+		return (u64) n.a | ((u64) n.b << 32);
+	}
+
+	f64 FlatView::floating(u32 index) const {
+		u64 bits = integer(index);
+		f64 value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	std::string_view FlatView::string(u32 index) const {
+		auto& n = nodes[index];
+		return text.substr(n.a, n.b);
+	}
+
+	u64 FlatTree::integer(u32 index) const {
+		return view().integer(index);
+	}
+
+	f64 FlatTree::floating(u32 index) const {
+		return view().floating(index);
+	}
+
+	std::string_view FlatTree::string(u32 index) const {
+		return view().string(index);
+	}
+
+	FlatView FlatTree::view() const {
+		FlatView view;
+		view.nodes = mist::Span<const Node>(nodes.data(), size());
+		view.positions = mist::Span<const mist::Pos>(positions.data(), (u32) positions.size());
+		view.extra = mist::Span<const u32>(extra.data(), (u32) extra.size());
+		view.text = std::string_view(text.data(), text.size());
+		view.root = root;
+		return view;
+	}
+
+	u64 FlatTree::bytes() const {
+		return nodes.size() * sizeof(Node) + positions.size() * sizeof(mist::Pos) +
+			extra.size() * sizeof(u32) + text.size();
+	}
+
+	// nodes have no padding, they compare as bytes.
+	bool FlatTree::operator==(const FlatTree& other) const {
+		return root == other.root && nodes.size() == other.nodes.size() && extra == other.extra && text == other.text &&
+			std::memcmp(nodes.data(), other.nodes.data(), nodes.size() * sizeof(Node)) == 0 &&
+			std::memcmp(positions.data(), other.positions.data(), positions.size() * sizeof(mist::Pos)) == 0;
+	}
+
+	FlatTree flatten(ast::Module* module) {
+		FlatTree tree;
+		Flattener flattener(tree);
+		auto& decls = module->toplevelDeclarations;
+		tree.root = flattener.decls(mist::Span<Decl*>(decls.data(), (u32) decls.size()));
+		return tree;
+	}
+
+	Module* expand(const FlatView& tree, io::File* file, mist::Interpreter* interp,
+		const std::vector<u32>& symbols, i64 shift) {
+		auto module = new Module(file);
+		Expander expander{tree, module, interp, symbols, shift};
+		for(auto handle : tree.list(tree.root))
+			if(auto decl = expander.decl(handle))
+				module->add_decl(decl);
+		return module;
+	}
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "ast_common.hpp"
+#include "ast_decl.hpp"
+#include "ast_expr.hpp"
+#include "ast_typespec.hpp"
+
+#include <string_view>
+
+namespace ast {
+
+	// Every kind of node in a FlatTree. Expressions, declarations and type
+	// specs share one pool, so a handle is enough to find any node. The
+	// comment after each tag says what a, b and c hold, [x] is a list.
+	enum NodeTag : u8 {
+		Node_None,				// handle 0, no node
+
+		Node_Ident,				// a: symbol id
+
+		// expressions
+		Node_Value,				// a: ident, b: [generic values]
+		Node_Tuple,				// a: [values]
+		Node_IntegerConst,		// sub: ConstantType, a: low bits, b: high bits
+		Node_FloatConst,		// sub: ConstantType, a: low bits, b: high bits
+		Node_StringConst,		// a: offset in text, b: length
+		Node_BooleanConst,		// a: value
+		Node_CharConst,			// a: value
+		Node_Binary,			// sub: BinaryOp, a: lhs, b: rhs
+		Node_Unary,				// sub: UnaryOp, a: operand
+		Node_If,				// a: cond, b: body
+		Node_While,				// a: cond, b: body
+		Node_Loop,				// a: body
+		Node_For,				// a: index, b: expr, c: body
+		Node_Match,				// a: cond, b: [arms]
+		Node_MatchArm,			// a: name, b: value ident, c: body
+		Node_DeclExpr,			// a: decl
+		Node_Parenthesis,		// a: operand, b: [params]
+		Node_Selector,			// a: operand, b: element
+		Node_Break,
+		Node_Continue,
+		Node_Return,			// a: [returns]
+		Node_Cast,				// a: expr, b: type
+		Node_Range,				// a: low, b: high, c: count
+		Node_Slice,				// a: low, b: high
+		Node_TupleIndex,		// a: operand, b: index
+		Node_Assignment,		// sub: AssignmentOp, a: [lvalues], b: expr
+		Node_Block,				// a: [elements]
+		Node_Binding,			// a: name, b: expr
+		Node_UnitLit,
+		Node_SelfLit,
+		Node_LazyBody,			// a: begin, b: end, c: restrictions. A function body that was skipped
+
+		// declarations, the name is always in a
+		Node_Local,				// a: name, b: type, c: init
+		Node_MultiLocal,		// a: [names], b: [types], c: [inits]
+		Node_Struct,			// a: name, b: record of [fields], [derives], where, generics
+		Node_TypeClass,			// a: name, b: [members], c: generics
+		Node_Function,			// a: name, b: record of [params], [returns], body, generics
+		Node_OpFunction,		// sub: Op, b: record of [params], [returns], body, generics
+		Node_Use,				// a: name, b: path, c: [paths]
+		Node_Impl,				// a: name, b: [methods], c: generics
+		Node_Generic,			// a: name, b: [bounds]
+		Node_Generics,			// a: [generic declarations]
+		Node_Enum,				// a: name, b: [members], c: generics
+		Node_EnumMember,		// sub: EnumDeclKind, a: name, b: [types], c: init
+		Node_Where,				// a: [elements]
+		Node_WhereElement,		// a: parameter ident, b: [types]
+		Node_Path,				// a: [idents]
+
+		// type specs
+		Node_NamedSpec,			// a: name, b: [generic values]
+		Node_TupleSpec,			// a: [types]
+		Node_FunctionSpec,		// a: [parameters], b: [returns]
+		Node_TypeClassSpec,		// a: named spec
+		Node_ArraySpec,			// a: element, b: size
+		Node_DynamicArraySpec,	// a: element
+		Node_MapSpec,			// a: key, b: value
+		Node_PointerSpec,		// a: base
+		Node_ReferenceSpec,		// a: base
+		Node_ConstantSpec,		// a: base
+		Node_PathSpec,			// a: [named specs]
+		Node_UnitSpec
+	};
+
+	enum NodeFlag : u16 {
+		NodeFlag_Public = 0x0001,		/// declarations
+		NodeFlag_Self = 0x0002,			/// a Node_Local that is the self parameter
+		NodeFlag_Params = 0x0004,		/// a Node_NamedSpec with generic values, even an empty list
+	};
+
+	struct Node {
+		NodeTag tag;
+		u8 sub;
+		u16 flags;
+		u32 a;
+		u32 b;
+		u32 c;
+	};
+
+	static_assert(sizeof(Node) == 16, "nodes are kept to a quarter of a cache line");
+
+	/// The arrays of a FlatTree without owning them, they may be in a mapped
+	/// file. It is read the same way as the tree.
+	struct FlatView {
+		mist::Span<const Node> nodes;
+		mist::Span<const mist::Pos> positions;
+		mist::Span<const u32> extra;
+		std::string_view text;
+		u32 root{0};
+
+		inline u32 size() const { return nodes.size(); }
+
+		inline const Node& node(u32 index) const { return nodes[index]; }
+		inline NodeTag tag(u32 index) const { return nodes[index].tag; }
+		inline mist::Pos pos(u32 index) const { return positions[index]; }
+
+		inline mist::Span<const u32> list(u32 index) const {
+			return mist::Span<const u32>(extra.data + index + 1, extra[index]);
+		}
+
+		inline u32 field(u32 index, u32 field) const { return extra[index + field]; }
+
+		u64 integer(u32 index) const;
+		f64 floating(u32 index) const;
+		std::string_view string(u32 index) const;
+	};
+
+	/// A module stored as flat arrays instead of a graph of pointers. Nodes
+	/// are addressed by u32 handles and the position of each node is kept in
+	/// a parallel array. Children are stored before their parent, so every
+	/// child has a smaller handle and a forward scan reaches a node after its
+	/// whole subtree. A list of children is an index into extra, where its
+	/// length is followed by the handles; 0 is the empty list. Nothing points
+	/// into memory, the arrays can be written out as they are.
+	struct FlatTree {
+		std::vector<Node> nodes;
+		std::vector<mist::Pos> positions;
+		std::vector<u32> extra;			/// lists and the records of nodes with more than three fields
+		std::vector<char> text;			/// decoded string constants
+		u32 root{0};					/// list of the top level declarations
+
+		inline u32 size() const { return (u32) nodes.size(); }
+
+		inline const Node& node(u32 index) const { return nodes[index]; }
+		inline NodeTag tag(u32 index) const { return nodes[index].tag; }
+		inline mist::Pos pos(u32 index) const { return positions[index]; }
+
+		/// the handles of the list at extra[index].
+		inline mist::Span<const u32> list(u32 index) const {
+			return mist::Span<const u32>(extra.data() + index + 1, extra[index]);
+		}
+
+		/// the field of a record at extra[index].
+		inline u32 field(u32 index, u32 field) const { return extra[index + field]; }
+
+		u64 integer(u32 index) const;
+		f64 floating(u32 index) const;
+		std::string_view string(u32 index) const;
+
+		/// the memory held by the arrays.
+		u64 bytes() const;
+
+		/// the same nodes, positions and text. Two parses of the same file
+		/// with the same interner flatten to equal trees.
+		bool operator==(const FlatTree& other) const;
+
+		FlatView view() const;
+	};
+
+	/// builds the flat form of a parsed module, the module is left as it is.
+	/// Bodies that were skipped are kept as their range in the file.
+	FlatTree flatten(ast::Module* module);
+
+	/// Builds a module of file back from its flat form. The value of an
+	/// identifier indexes symbols, or is the symbol id when symbols is empty,
+	/// and positions are moved by shift. String constants go to the literal
+	/// pool of interp, and a skipped body is parsed by interp when it is used.
+	Module* expand(const FlatView& tree, io::File* file, mist::Interpreter* interp,
+		const std::vector<u32>& symbols, i64 shift);
+}
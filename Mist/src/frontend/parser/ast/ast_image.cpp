@@ -0,0 +1,132 @@
+#include "ast_image.hpp"
+#include "interpreter.hpp"
+#include "utils/hash.hpp"
+
+#include <cstring>
+#include <unordered_map>
+
+namespace ast {
+	namespace {
+		const char Magic[4] = {'M', 'A', 'S', 'T'};
+
+		const u32 Sizes[ImageSections] = {
+			sizeof(Node), sizeof(mist::Pos), sizeof(u32), sizeof(char), sizeof(u32), sizeof(char)
+		};
+
+		inline u64 align(u64 offset) {
+			return (offset + 15) & ~(u64) 15;
+		}
+	}
+
+	std::vector<char> write_image(const FlatTree& tree, const mist::Interner& names, u32 base, u64 source) {
+		// identifiers are numbered in the order they are first used.
+		std::vector<Node> nodes(tree.nodes);
+		std::unordered_map<u32, u32> local;
+		std::vector<u32> starts{0};
+		std::string text;
+		for(auto& node : nodes) {
+			if(node.tag != Node_Ident)
+				continue;
+			auto result = local.emplace(node.a, (u32) local.size());
+			if(result.second) {
+				text.append(names.get(node.a));
+				starts.push_back((u32) text.size());
+			}
+			node.a = result.first->second;
+		}
+
+		std::vector<mist::Pos> positions(tree.positions);
+		for(auto& pos : positions)
+			if(pos.offset)
+				pos.offset = pos.offset - base + 1;
+
+		const void* sections[ImageSections] = {
+			nodes.data(), positions.data(), tree.extra.data(), tree.text.data(), starts.data(), text.data()
+		};
+
+		ImageHeader header{};
+		std::memcpy(header.magic, Magic, sizeof(Magic));
+		header.version = ImageVersion;
+		header.order = ImageOrder;
+		header.source = source;
+		header.root = tree.root;
+		header.counts[Image_Nodes] = (u32) nodes.size();
+		header.counts[Image_Positions] = (u32) positions.size();
+		header.counts[Image_Extra] = (u32) tree.extra.size();
+		header.counts[Image_Text] = (u32) tree.text.size();
+		header.counts[Image_Symbols] = (u32) starts.size();
+		header.counts[Image_SymbolText] = (u32) text.size();
+
+		u64 size = align(sizeof(ImageHeader));
+		for(u32 i = 0; i < ImageSections; ++i) {
+			header.offsets[i] = (u32) size;
+			size = align(size + (u64) header.counts[i] * Sizes[i]);
+		}
+		header.size = (u32) size;
+
+		std::vector<char> image(size, 0);
+		for(u32 i = 0; i < ImageSections; ++i)
+			if(header.counts[i])
+				std::memcpy(image.data() + header.offsets[i], sections[i], (u64) header.counts[i] * Sizes[i]);
+		u64 start = align(sizeof(ImageHeader));
+		header.check = mist::hash64(image.data() + start, size - start);
+		std::memcpy(image.data(), &header, sizeof(header));
+		return image;
+	}
+
+	bool Image::open(const std::string& path) {
+		// a file that is not read is not kept mapped, so it can be removed.
+		file.reset(new io::File(path));
+		if(!file->load() || !read(file->data(), file->size())) {
+			file.reset();
+			return false;
+		}
+		return true;
+	}
+
+	bool Image::read(const char* data, u64 size) {
+		if(size < sizeof(ImageHeader))
+			return false;
+
+		ImageHeader header;
+		std::memcpy(&header, data, sizeof(header));
+		if(std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != ImageVersion ||
+			header.order != ImageOrder || header.size != size)
+			return false;
+
+		// expand follows the handles and indices of the tree without checking
+		// them, only an image exactly as write_image made it is read.
+		u64 start = align(sizeof(ImageHeader));
+		if(size < start || mist::hash64(data + start, size - start) != header.check)
+			return false;
+
+		for(u32 i = 0; i < ImageSections; ++i) {
+			if(header.offsets[i] % 16 != 0 || header.offsets[i] < sizeof(ImageHeader) ||
+				(u64) header.offsets[i] + (u64) header.counts[i] * Sizes[i] > size)
+				return false;
+		}
+
+		auto section = [&](ImageSection i) { return data + header.offsets[i]; };
+		view.nodes = mist::Span<const Node>((const Node*) section(Image_Nodes), header.counts[Image_Nodes]);
+		view.positions = mist::Span<const mist::Pos>((const mist::Pos*) section(Image_Positions), header.counts[Image_Positions]);
+		view.extra = mist::Span<const u32>((const u32*) section(Image_Extra), header.counts[Image_Extra]);
+		view.text = std::string_view(section(Image_Text), header.counts[Image_Text]);
+		view.root = header.root;
+		hash = header.source;
+		starts = mist::Span<const u32>((const u32*) section(Image_Symbols), header.counts[Image_Symbols]);
+		text = section(Image_SymbolText);
+
+		if(view.nodes.empty() || view.positions.size() != view.nodes.size() || view.extra.empty() ||
+			view.root >= view.extra.size() || (u64) view.root + view.extra[view.root] >= view.extra.size() ||
+			starts.empty() || starts.back() > header.counts[Image_SymbolText])
+			return false;
+		return true;
+	}
+
+	Module* Image::expand(io::File* file, u32 base, mist::Interpreter* interp) const {
+		std::vector<u32> ids(symbols());
+		for(u32 i = 0; i < symbols(); ++i)
+			ids[i] = interp->intern(symbol(i));
+		return ast::expand(view, file, interp, ids, (i64) base - 1);
+	}
+}
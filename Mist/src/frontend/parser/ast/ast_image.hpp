@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ast_flat.hpp"
+#include "utils/file.hpp"
+#include "utils/interner.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ast {
+
+	// the arrays stored in an image, in the order they are written.
+	enum ImageSection {
+		Image_Nodes,
+		Image_Positions,
+		Image_Extra,
+		Image_Text,
+		Image_Symbols,			// where each symbol starts in Image_SymbolText, one more than there are symbols
+		Image_SymbolText,
+		ImageSections
+	};
+
+	static const u32 ImageVersion = 3;		// changes whenever the layout or the node tags change
+	static const u32 ImageOrder = 0x01020304;
+
+	struct ImageHeader {
+		char magic[4];					// "MAST"
+		u32 version;
+		u32 order;						// ImageOrder in the byte order of the writer
+		u32 size;						// bytes in the whole image
+		u64 source;						// hash of the text the tree was parsed from
+		u64 check;						// hash of everything after the header
+		u32 root;
+		u32 counts[ImageSections];		// elements in each section
+		u32 offsets[ImageSections];		// bytes from the start of the image, a multiple of 16
+	};
+
+	/// Writes a FlatTree in the form an Image reads. The header is followed
+	/// by the arrays of the tree as they are in memory and by the text of every
+	/// identifier the tree uses. An identifier node holds an index into that
+	/// table instead of a symbol id, and positions are stored as if the file
+	/// was the first one in the address space, starting at offset 1. Nothing
+	/// in the image depends on the process that wrote it. base is the offset
+	/// of the file of the tree and source the hash of its content.
+	std::vector<char> write_image(const FlatTree& tree, const mist::Interner& names, u32 base, u64 source = 0);
+
+	/// An image opened for reading. The tree is used where it lies in the
+	/// mapping, nothing is copied or fixed up until it is expanded. An image
+	/// whose content does not match the hash in its header is not read, so
+	/// a truncated or damaged file is never expanded.
+	class Image {
+		public:
+			/// maps the image at path, false when it can not be read, is
+			/// damaged or is not an image of this version and byte order.
+			bool open(const std::string& path);
+
+			/// the same for an image in memory, data has to outlive the Image.
+			bool read(const char* data, u64 size);
+
+			inline const FlatView& tree() const { return view; }
+
+			/// the hash of the text the tree was parsed from, 0 when it was not given.
+			inline u64 source() const { return hash; }
+
+			inline u32 symbols() const { return starts.empty() ? 0 : starts.size() - 1; }
+			inline std::string_view symbol(u32 index) const {
+				return std::string_view(text + starts[index], starts[index + 1] - starts[index]);
+			}
+
+			/// rebuilds the module of file, its nodes are placed in the address
+			/// space from base and its identifiers are interned in interp.
+			Module* expand(io::File* file, u32 base, mist::Interpreter* interp) const;
+
+		private:
+			std::unique_ptr<io::File> file;		// the mapping, when the image was opened from a path
+			FlatView view;
+			u64 hash{0};
+			mist::Span<const u32> starts;
+			const char* text{nullptr};
+	};
+}
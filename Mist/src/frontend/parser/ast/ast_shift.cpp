@@ -0,0 +1,58 @@
+#include "ast_shift.hpp"
+#include "ast_expr.hpp"
+#include "ast_typespec.hpp"
+#include "ast_visitor.hpp"
+
+namespace ast {
+	namespace {
+		struct Shifter : public Visitor<Shifter> {
+			i64 offset;
+			i64 text;
+			Ident* shared{nullptr};		// the name of a use that is also the last name of its path
+
+			Shifter(i64 offset, i64 text) : offset(offset), text(text) {}
+
+			// offset 0 is no position and stays that way.
+			Walk move(mist::Pos& pos) {
+				if(pos.offset)
+					pos.offset = (u32) (pos.offset + offset);
+				return Recurse;
+			}
+
+			Walk enter_expr(Expr* e) { return move(e->p); }
+			Walk enter_decl(Decl* d) { return move(d->pos); }
+			Walk enter_spec(TypeSpec* s) { return move(s->p); }
+			Walk enter_path(UsePath* p) { return move(p->pos); }
+			Walk enter_where(WhereClause* w) { return move(w->pos); }
+			Walk enter_where_element(WhereElement* e) { return move(e->pos); }
+
+			// the parser gives a use the last name of its path, it is moved with the path.
+			Walk enter_use(UseDecl* d) {
+				if(d->path && !d->path->names.empty() && d->name == d->path->names.back())
+					shared = d->name;
+				return move(d->pos);
+			}
+
+			Walk enter_ident(Ident* ident) {
+				if(ident == shared) {
+					shared = nullptr;
+					return Prune;
+				}
+				return move(ident->pos);
+			}
+
+			// a skipped body stays skipped, only its range in the file moves.
+			Walk enter_lazy_body(LazyBody* lazy) {
+				lazy->begin = (u32) (lazy->begin + text);
+				lazy->end = (u32) (lazy->end + text);
+				return Prune;
+			}
+		};
+	}
+
+	void shift(Decl* decl, i64 offset, i64 text) {
+		if(offset == 0 && text == 0)
+			return;
+		Shifter(offset, text).walk(decl);
+	}
+}
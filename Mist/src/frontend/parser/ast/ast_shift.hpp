@@ -0,0 +1,14 @@
+#pragma once
+
+#include "ast_common.hpp"
+#include "ast_decl.hpp"
+
+namespace ast {
+
+	/// Moves every position in decl by offset, in place, and the range in
+	/// the file of every body that is still skipped by text. A declaration
+	/// kept across an edit before it is moved this way: offset is how far
+	/// its tokens moved in the address space and text how far in the file.
+	/// Skipped bodies are left skipped. Nothing else may use decl meanwhile.
+	void shift(Decl* decl, i64 offset, i64 text);
+}
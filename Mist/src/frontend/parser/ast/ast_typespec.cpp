@@ -4,7 +4,7 @@
 
 namespace ast {
 
-	const static std::vector<std::string> spec_names = {
+	static constexpr const char* spec_names[] = {
 		ToString(Named),
 		ToString(TupleType),
 		ToString(FunctionType),
@@ -22,11 +22,11 @@ namespace ast {
 
 	TypeSpec::TypeSpec(TypeSpecKind k, mist::Pos p) : k(k), p(p) { } TypeSpec::TypeSpec(TypeSpec* base, TypeSpecKind k, mist::Pos p) : k(k), p(p), base(base) { }
 
-	const std::string& TypeSpec::name() {
+	const char* TypeSpec::name() {
 		return spec_names[k];
 	}
 
-	GenericParameters::GenericParameters(const std::vector<Expr*>& expr) : exprs(expr) {
+	GenericParameters::GenericParameters(mist::Span<Expr*> expr) : exprs(expr) {
 	}
 
 	NamedSpec::NamedSpec(Ident* name, GenericParameters* params, mist::Pos pos) :
@@ -34,11 +34,11 @@ namespace ast {
 
 	}
 
-	TupleSpec::TupleSpec(const std::vector<TypeSpec*>& types, mist::Pos pos) :
+	TupleSpec::TupleSpec(mist::Span<TypeSpec*> types, mist::Pos pos) :
 		TypeSpec(TupleType, pos), types(types) {
 	}
 
-	FunctionSpec::FunctionSpec(const std::vector<TypeSpec*>& parameters, const std::vector<TypeSpec*>& returns,
+	FunctionSpec::FunctionSpec(mist::Span<TypeSpec*> parameters, mist::Span<TypeSpec*> returns,
 		mist::Pos pos) : TypeSpec(FunctionType, pos), parameters(parameters), returns(returns) {
 	}
 
@@ -63,7 +63,7 @@ namespace ast {
 	ConstantSpec::ConstantSpec(TypeSpec* base, mist::Pos pos) : TypeSpec(base, Constant, pos) {
 	}
 
-	PathSpec::PathSpec(const std::vector<NamedSpec*>& path, mist::Pos pos) : TypeSpec(Path, pos), path(path) {
+	PathSpec::PathSpec(mist::Span<NamedSpec*> path, mist::Pos pos) : TypeSpec(Path, pos), path(path) {
 	}
 
 	UnitSpec::UnitSpec(mist::Pos pos) : TypeSpec(Unit, pos) {}
@@ -30,7 +30,7 @@ namespace ast {
 		TypeSpec(TypeSpecKind k, mist::Pos p);
 		TypeSpec(TypeSpec* base, TypeSpecKind k, mist::Pos p);
 
-		const std::string& name();
+		const char* name();
 	};
 
 
@@ -40,9 +40,9 @@ namespace ast {
 	};
 
 	struct GenericParameters {
-		std::vector<Expr*> exprs;
+		mist::Span<Expr*> exprs;
 
-		GenericParameters(const std::vector<Expr*>& expr);
+		GenericParameters(mist::Span<Expr*> expr);
 	};
 
 	struct NamedSpec : public TypeSpec {
@@ -53,16 +53,16 @@ namespace ast {
 	};
 
 	struct TupleSpec : public TypeSpec  {
-		std::vector<TypeSpec*> types;
+		mist::Span<TypeSpec*> types;
 
-		TupleSpec(const std::vector<TypeSpec*>& types, mist::Pos pos);
+		TupleSpec(mist::Span<TypeSpec*> types, mist::Pos pos);
 	};
 
 	struct FunctionSpec : public TypeSpec  {
-		std::vector<TypeSpec*> parameters;
-		std::vector<TypeSpec*> returns;
+		mist::Span<TypeSpec*> parameters;
+		mist::Span<TypeSpec*> returns;
 
-		FunctionSpec(const std::vector<TypeSpec*>& parameters, const std::vector<TypeSpec*>& returns,
+		FunctionSpec(mist::Span<TypeSpec*> parameters, mist::Span<TypeSpec*> returns,
 			mist::Pos pos);
 	};
 
@@ -103,8 +103,8 @@ namespace ast {
 	};
 
 	struct PathSpec : public TypeSpec  {
-		std::vector<NamedSpec*> path;
-		PathSpec(const std::vector<NamedSpec*>& path, mist::Pos pos);
+		mist::Span<NamedSpec*> path;
+		PathSpec(mist::Span<NamedSpec*> path, mist::Pos pos);
 	};
 
 	struct UnitSpec : public TypeSpec {
@@ -0,0 +1,393 @@
+#pragma once
+
+#include "ast_common.hpp"
+#include "ast_decl.hpp"
+#include "ast_expr.hpp"
+#include "ast_typespec.hpp"
+
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Every node a Visitor dispatches on: the kind, the node type and the name
+// of its hooks. A kind without a node of its own is visited as its base.
+#define AST_EXPR_NODES(X) \
+	X(Value, ValueExpr, value) \
+	X(Tuple, TupleExpr, tuple) \
+	X(IntegerConst, IntegerConstExpr, integer_const) \
+	X(FloatConst, FloatConstExpr, float_const) \
+	X(StringConst, StringConstExpr, string_const) \
+	X(BooleanConst, BooleanConstExpr, boolean_const) \
+	X(CharConst, CharConstExpr, char_const) \
+	X(Binary, BinaryExpr, binary) \
+	X(Unary, UnaryExpr, unary) \
+	X(If, IfExpr, if) \
+	X(While, WhileExpr, while) \
+	X(Loop, LoopExpr, loop) \
+	X(For, ForExpr, for) \
+	X(Match, MatchExpr, match) \
+	X(DeclDecl, DeclExpr, decl_expr) \
+	X(Parenthesis, ParenthesisExpr, parenthesis) \
+	X(Selector, SelectorExpr, selector) \
+	X(Break, BreakExpr, break) \
+	X(Continue, ContinueExpr, continue) \
+	X(Return, ReturnExpr, return) \
+	X(Cast, CastExpr, cast) \
+	X(Range, RangeExpr, range) \
+	X(Slice, SliceExpr, slice) \
+	X(TupleIndex, TupleIndexExpr, tuple_index) \
+	X(Assignment, AssignmentExpr, assignment) \
+	X(Block, BlockExpr, block) \
+	X(StructLiteral, Expr, struct_literal) \
+	X(Binding, BindingExpr, binding) \
+	X(UnitLit, UnitExpr, unit) \
+	X(SelfLit, SelfExpr, self)
+
+#define AST_DECL_NODES(X) \
+	X(Local, LocalDecl, local) \
+	X(MultiLocal, MultiLocalDecl, multi_local) \
+	X(Struct, StructDecl, struct) \
+	X(TypeClass, TypeClassDecl, typeclass) \
+	X(Function, FunctionDecl, function) \
+	X(OpFunction, OpFunctionDecl, op_function) \
+	X(Use, UseDecl, use) \
+	X(Impl, ImplDecl, impl) \
+	X(Generic, GenericDecl, generic) \
+	X(Enum, EnumDecl, enum) \
+	X(EnumMember, EnumMemberDecl, enum_member)
+
+#define AST_SPEC_NODES(X) \
+	X(Named, NamedSpec, named_spec) \
+	X(TupleType, TupleSpec, tuple_spec) \
+	X(FunctionType, FunctionSpec, function_spec) \
+	X(TypeClassType, TypeClassSpec, typeclass_spec) \
+	X(Array, ArraySpec, array_spec) \
+	X(DynamicArray, DynamicArraySpec, dynamic_array_spec) \
+	X(Map, MapSpec, map_spec) \
+	X(Pointer, PointerSpec, pointer_spec) \
+	X(Reference, ReferenceSpec, reference_spec) \
+	X(Constant, ConstantSpec, constant_spec) \
+	X(Path, PathSpec, path_spec) \
+	X(Unit, UnitSpec, unit_spec)
+
+// The parts of nodes that have no kind of their own, they are reached
+// through their parent. A skipped function body is a LazyBody until a pass
+// asks for it to be parsed.
+#define AST_OTHER_NODES(X) \
+	X(Ident, ident) \
+	X(UsePath, path) \
+	X(MatchArm, match_arm) \
+	X(WhereClause, where) \
+	X(WhereElement, where_element) \
+	X(Generics, generics) \
+	X(LazyBody, lazy_body)
+
+namespace ast {
+
+	// what a walk does after entering a node.
+	enum Walk {
+		Recurse,	// visits the children, then leaves the node
+		Prune,		// leaves the node without visiting its children
+		Halt		// ends the whole walk
+	};
+
+	/// A depth first walk over the ast that dispatches on the kind of each
+	/// node through tables built at compile time, no virtual calls involved.
+	///
+	/// Derived hides the hooks it needs. enter_binary(BinaryExpr*) is called
+	/// before the children of a binary expression and leave_binary after them,
+	/// returning false from a leave hook ends the walk. A hook that is not
+	/// hidden falls back to enter_expr, enter_decl or enter_spec (and their
+	/// leave forms) so a pass can also handle a whole category at once. The
+	/// nodes of AST_OTHER_NODES have hooks of their own and no fallback.
+	///
+	/// Every node ast::flatten stores is reached, names included. A name
+	/// shared by two nodes, like the name of a use and the last name of its
+	/// path, is reached through both. A body skipped by the parser is
+	/// entered as a LazyBody, it is parsed and walked unless the pass prunes.
+	template <typename Derived>
+	class Visitor {
+		public:
+			/// false when a hook halted the walk.
+			bool walk(Module* module) {
+				for(auto decl : module->toplevelDeclarations)
+					if(!walk(decl))
+						return false;
+				return true;
+			}
+
+			bool walk(Expr* expr) {
+				return !expr || exprs[expr->k](*this, expr);
+			}
+
+			bool walk(Decl* decl) {
+				return !decl || decls[decl->k](*this, decl);
+			}
+
+			bool walk(TypeSpec* spec) {
+				return !spec || specs[spec->k](*this, spec);
+			}
+
+			Walk enter_expr(Expr*) { return Recurse; }
+			bool leave_expr(Expr*) { return true; }
+			Walk enter_decl(Decl*) { return Recurse; }
+			bool leave_decl(Decl*) { return true; }
+			Walk enter_spec(TypeSpec*) { return Recurse; }
+			bool leave_spec(TypeSpec*) { return true; }
+
+#define AST_VISITOR_HOOKS(kind, T, hook, base) \
+			Walk enter_##hook(T* node) { return derived().enter_##base(node); } \
+			bool leave_##hook(T* node) { return derived().leave_##base(node); }
+#define AST_VISITOR_EXPR_HOOKS(kind, T, hook) AST_VISITOR_HOOKS(kind, T, hook, expr)
+#define AST_VISITOR_DECL_HOOKS(kind, T, hook) AST_VISITOR_HOOKS(kind, T, hook, decl)
+#define AST_VISITOR_SPEC_HOOKS(kind, T, hook) AST_VISITOR_HOOKS(kind, T, hook, spec)
+			AST_EXPR_NODES(AST_VISITOR_EXPR_HOOKS)
+			AST_DECL_NODES(AST_VISITOR_DECL_HOOKS)
+			AST_SPEC_NODES(AST_VISITOR_SPEC_HOOKS)
+#undef AST_VISITOR_SPEC_HOOKS
+#undef AST_VISITOR_DECL_HOOKS
+#undef AST_VISITOR_EXPR_HOOKS
+#undef AST_VISITOR_HOOKS
+
+#define AST_VISITOR_OTHER_HOOKS(T, hook) \
+			Walk enter_##hook(T*) { return Recurse; } \
+			bool leave_##hook(T*) { return true; }
+			AST_OTHER_NODES(AST_VISITOR_OTHER_HOOKS)
+#undef AST_VISITOR_OTHER_HOOKS
+
+		protected:
+			Derived& derived() { return static_cast<Derived&>(*this); }
+
+			template <typename T>
+			bool walk(const mist::Span<T*>& nodes) {
+				for(auto node : nodes)
+					if(!walk(node))
+						return false;
+				return true;
+			}
+
+			// enters the node, walks its children and leaves it.
+#define AST_VISITOR_WALK(T, hook) \
+			bool walk(T* node) { \
+				if(!node) \
+					return true; \
+				auto walk = derived().enter_##hook(node); \
+				if(walk == Halt || (walk == Recurse && !children(node))) \
+					return false; \
+				return derived().leave_##hook(node); \
+			}
+			AST_VISITOR_WALK(Ident, ident)
+			AST_VISITOR_WALK(UsePath, path)
+			AST_VISITOR_WALK(MatchArm, match_arm)
+			AST_VISITOR_WALK(WhereClause, where)
+			AST_VISITOR_WALK(WhereElement, where_element)
+			AST_VISITOR_WALK(Generics, generics)
+#undef AST_VISITOR_WALK
+
+			// the body of a function, parsed first when it was skipped and
+			// the pass does not prune the LazyBody.
+			template <typename F>
+			bool body(F* function) {
+				auto parsed = function->parsed.load(std::memory_order_acquire);
+				if(parsed || !function->lazy)
+					return walk(parsed);
+				auto walk = derived().enter_lazy_body(function->lazy);
+				if(walk == Halt || (walk == Recurse && !this->walk(function->body())))
+					return false;
+				return derived().leave_lazy_body(function->lazy);
+			}
+
+			// the children of each node, the same ones ast::flatten stores.
+			template <typename T>
+			bool children(T*) { return true; }
+
+			bool children(UsePath* p) { return walk(p->names); }
+			bool children(MatchArm* arm) { return walk(arm->name) && walk(arm->value) && walk(arm->body); }
+			bool children(WhereClause* w) { return walk(w->elements); }
+			bool children(WhereElement* e) { return walk(e->parameter) && walk(e->type); }
+			bool children(Generics* g) { return walk(g->parameters); }
+
+			bool children(ValueExpr* e) { return walk(e->name) && walk(e->genericValues); }
+			bool children(TupleExpr* e) { return walk(e->values); }
+			bool children(BinaryExpr* e) { return walk(e->lhs) && walk(e->rhs); }
+			bool children(UnaryExpr* e) { return walk(e->expr); }
+			bool children(IfExpr* e) { return walk(e->cond) && walk(e->body); }
+			bool children(WhileExpr* e) { return walk(e->cond) && walk(e->body); }
+			bool children(LoopExpr* e) { return walk(e->body); }
+			bool children(ForExpr* e) { return walk(e->index) && walk(e->expr) && walk(e->body); }
+			bool children(MatchExpr* e) { return walk(e->cond) && walk(e->arms); }
+			bool children(DeclExpr* e) { return walk(e->decl); }
+			bool children(ParenthesisExpr* e) { return walk(e->operand) && walk(e->params); }
+			bool children(SelectorExpr* e) { return walk(e->operand) && walk(e->element); }
+			bool children(ReturnExpr* e) { return walk(e->returns); }
+			bool children(CastExpr* e) { return walk(e->expr) && walk(e->ty); }
+			bool children(RangeExpr* e) { return walk(e->low) && walk(e->high) && walk(e->count); }
+			bool children(SliceExpr* e) { return walk(e->low) && walk(e->high); }
+			bool children(TupleIndexExpr* e) { return walk(e->operand); }
+			bool children(AssignmentExpr* e) { return walk(e->lvalues) && walk(e->expr); }
+			bool children(BlockExpr* e) { return walk(e->elements); }
+			bool children(BindingExpr* e) { return walk(e->name) && walk(e->expr); }
+
+			// the name of a declaration comes before its other children.
+			bool children(LocalDecl* d) { return walk(d->name) && walk(d->sp) && walk(d->init); }
+			bool children(MultiLocalDecl* d) {
+				return walk(d->name) && walk(d->names) && walk(d->sps) && walk(d->inits);
+			}
+			bool children(StructDecl* d) {
+				return walk(d->name) && walk(d->fields) && walk(d->derives) && walk(d->where) && walk(d->generics);
+			}
+			bool children(TypeClassDecl* d) { return walk(d->name) && walk(d->members) && walk(d->generics); }
+			bool children(FunctionDecl* d) {
+				return walk(d->name) && walk(d->parameters) && walk(d->returns) && body(d) && walk(d->generics);
+			}
+			bool children(OpFunctionDecl* d) {
+				return walk(d->name) && walk(d->parameters) && walk(d->returns) && body(d) && walk(d->generics);
+			}
+			bool children(UseDecl* d) { return walk(d->name) && walk(d->path) && walk(d->fields); }
+			bool children(ImplDecl* d) { return walk(d->name) && walk(d->methods) && walk(d->generics); }
+			bool children(GenericDecl* d) { return walk(d->name) && walk(d->bounds); }
+			bool children(EnumDecl* d) { return walk(d->name) && walk(d->members) && walk(d->generics); }
+			bool children(EnumMemberDecl* d) { return walk(d->name) && walk(d->types) && walk(d->init); }
+
+			bool children(NamedSpec* s) { return walk(s->name) && (!s->params || walk(s->params->exprs)); }
+			bool children(TupleSpec* s) { return walk(s->types); }
+			bool children(FunctionSpec* s) { return walk(s->parameters) && walk(s->returns); }
+			bool children(TypeClassSpec* s) { return walk(s->name); }
+			bool children(ArraySpec* s) { return walk(s->base) && walk(s->size); }
+			bool children(DynamicArraySpec* s) { return walk(s->base); }
+			bool children(MapSpec* s) { return walk(s->key) && walk(s->value); }
+			bool children(PointerSpec* s) { return walk(s->base); }
+			bool children(ReferenceSpec* s) { return walk(s->base); }
+			bool children(ConstantSpec* s) { return walk(s->base); }
+			bool children(PathSpec* s) { return walk(s->path); }
+
+		private:
+			template <typename Base>
+			using Step = bool (*)(Visitor&, Base*);
+
+			// enters the node, walks its children and leaves it.
+#define AST_VISITOR_STEP(kind, T, hook) \
+			steps[kind] = [](Visitor& visitor, Base* base) { \
+				auto node = static_cast<T*>(base); \
+				auto& derived = visitor.derived(); \
+				auto walk = derived.enter_##hook(node); \
+				if(walk == Halt || (walk == Recurse && !visitor.children(node))) \
+					return false; \
+				return derived.leave_##hook(node); \
+			};
+
+			template <typename Base, u32 Count>
+			static constexpr std::array<Step<Base>, Count> table() {
+				std::array<Step<Base>, Count> steps{};
+				if constexpr (std::is_same<Base, Expr>::value) {
+					AST_EXPR_NODES(AST_VISITOR_STEP)
+				}
+				else if constexpr (std::is_same<Base, Decl>::value) {
+					AST_DECL_NODES(AST_VISITOR_STEP)
+				}
+				else {
+					AST_SPEC_NODES(AST_VISITOR_STEP)
+				}
+				return steps;
+			}
+#undef AST_VISITOR_STEP
+
+			// indexed by the kind of the node.
+			static constexpr std::array<Step<Expr>, SelfLit + 1> exprs = table<Expr, SelfLit + 1>();
+			static constexpr std::array<Step<Decl>, EnumMember + 1> decls = table<Decl, EnumMember + 1>();
+			static constexpr std::array<Step<TypeSpec>, Unit + 1> specs = table<TypeSpec, Unit + 1>();
+	};
+
+	/// Runs several passes in one walk, so each node is reached once however
+	/// many passes there are. Every hook of the passes is called in the order
+	/// they were given. A pass that prunes a node sees nothing under it while
+	/// the others go on, a pass that halts sees nothing more. The walk only
+	/// stops once every pass has halted.
+	template <typename... Passes>
+	class Fused : public Visitor<Fused<Passes...>> {
+		public:
+			Fused(Passes&... passes) : passes(passes...) {}
+
+#define AST_FUSED_HOOKS(kind, T, hook) \
+			Walk enter_##hook(T* node) { \
+				return enter_each([node](auto& pass) { return pass.enter_##hook(node); }); \
+			} \
+			bool leave_##hook(T* node) { \
+				return leave_each([node](auto& pass) { return pass.leave_##hook(node); }); \
+			}
+			AST_EXPR_NODES(AST_FUSED_HOOKS)
+			AST_DECL_NODES(AST_FUSED_HOOKS)
+			AST_SPEC_NODES(AST_FUSED_HOOKS)
+#define AST_FUSED_OTHER_HOOKS(T, hook) AST_FUSED_HOOKS(_, T, hook)
+			AST_OTHER_NODES(AST_FUSED_OTHER_HOOKS)
+#undef AST_FUSED_OTHER_HOOKS
+#undef AST_FUSED_HOOKS
+
+		private:
+			static constexpr u32 Count = sizeof...(Passes);
+			static_assert(Count > 0, "a fused walk needs a pass");
+
+			std::tuple<Passes&...> passes;
+			std::array<u32, Count> pruned{};	// the depth of the node a pass pruned, 0 while it takes part
+			std::array<bool, Count> halted{};
+			u32 depth{0};						// of the node being entered or left, from 1
+
+			template <typename F>
+			Walk enter_each(F f) {
+				++depth;
+				enter_each(f, std::index_sequence_for<Passes...>());
+
+				bool live = false, recurse = false;
+				for(u32 i = 0; i < Count; ++i) {
+					live |= !halted[i];
+					recurse |= !halted[i] && !pruned[i];
+				}
+				if(!live)
+					return Halt;
+				return recurse ? Recurse : Prune;
+			}
+
+			template <typename F, size_t... I>
+			void enter_each(F& f, std::index_sequence<I...>) {
+				(enter_one<I>(f), ...);
+			}
+
+			template <size_t I, typename F>
+			void enter_one(F& f) {
+				if(halted[I] || pruned[I])
+					return;
+				switch(f(std::get<I>(passes))) {
+					case Halt: halted[I] = true; break;
+					case Prune: pruned[I] = depth; break;
+					case Recurse: break;
+				}
+			}
+
+			template <typename F>
+			bool leave_each(F f) {
+				leave_each(f, std::index_sequence_for<Passes...>());
+				--depth;
+
+				for(u32 i = 0; i < Count; ++i)
+					if(!halted[i])
+						return true;
+				return false;
+			}
+
+			template <typename F, size_t... I>
+			void leave_each(F& f, std::index_sequence<I...>) {
+				(leave_one<I>(f), ...);
+			}
+
+			template <size_t I, typename F>
+			void leave_one(F& f) {
+				// a pass that pruned an ancestor never entered this node.
+				if(halted[I] || (pruned[I] && pruned[I] < depth))
+					return;
+				pruned[I] = 0;
+				if(!f(std::get<I>(passes)))
+					halted[I] = true;
+			}
+	};
+}
@@ -0,0 +1,85 @@
+#include "parse_cache.hpp"
+#include "interpreter.hpp"
+#include "ast/ast_flat.hpp"
+#include "ast/ast_image.hpp"
+#include "utils/trace.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace mist {
+	ParseCache::ParseCache(const std::string& dir) : dir(dir) {
+		std::error_code error;
+		std::filesystem::create_directories(dir, error);
+		usable = std::filesystem::is_directory(dir, error);
+		if(!usable)
+			std::cerr << "unable to use '" << dir << "' as the parse cache" << std::endl;
+	}
+
+	ast::Module* ParseCache::find(io::File* file, bool lazy, Interpreter* interp) {
+		if(!usable) {
+			++misses;
+			return nullptr;
+		}
+
+		// an entry that can not be read, damaged or of another version, is
+		// removed. A module with errors is never stored, so it would stay.
+		auto path = entry(file, lazy);
+		ast::Image image;
+		bool read = image.open(path);
+		if(!read || image.source() != file->hash()) {
+			MIST_TRACE(trace::Info, "cache miss", file->name().c_str(), 0, 0);
+			if(!read) {
+				std::error_code error;
+				std::filesystem::remove(path, error);
+			}
+			++misses;
+			return nullptr;
+		}
+
+		MIST_TRACE(trace::Info, "cache hit", file->name().c_str(), 0, image.tree().size());
+		++hits;
+		return image.expand(file, interp->sources().base(file), interp);
+	}
+
+	void ParseCache::store(io::File* file, bool lazy, ast::Module* module, Interpreter* interp) {
+		if(!usable)
+			return;
+
+		auto tree = ast::flatten(module);
+		auto image = ast::write_image(tree, interp->interner(), interp->sources().base(file), file->hash());
+
+		// the temporary name is unique to the thread, other processes may share the directory.
+		auto path = entry(file, lazy);
+		auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+		auto temporary = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) ^ (u64) stamp) + ".tmp";
+		bool written;
+		{
+			std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+			written = (bool) out.write(image.data(), (std::streamsize) image.size());
+		}
+
+		std::error_code error;
+		if(written)
+			std::filesystem::rename(temporary, path, error);
+		if(!written || error) {
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+		++stores;
+	}
+
+	void ParseCache::report(std::ostream& out) {
+		out << "Parse cache: " << hits << " hits, " << misses << " misses, " << stores << " written" << std::endl;
+	}
+
+	std::string ParseCache::entry(io::File* file, bool lazy) {
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx%s.mast", (unsigned long long) file->hash(), lazy ? "l" : "");
+		return dir + "/" + name;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "common.hpp"
+#include "utils/file.hpp"
+#include "ast/ast_common.hpp"
+
+#include <atomic>
+#include <ostream>
+#include <string>
+
+namespace mist {
+	class Interpreter;
+
+	/// Parsed modules kept in a directory between runs. An entry is the image
+	/// of a module named after the hash of the text it was parsed from, so a
+	/// file that did not change is expanded from its image instead of being
+	/// lexed and parsed. A changed file hashes to another entry; entries that
+	/// are no longer used are left for the user to clear. Any number of
+	/// threads may use the cache at once.
+	class ParseCache {
+		public:
+			ParseCache(const std::string& dir);
+
+			/// the module of file from its entry, nullptr when there is none.
+			/// file has to be loaded, the module is placed at its base. lazy
+			/// asks for the entry written with skipped bodies. An entry that
+			/// can not be read is removed.
+			ast::Module* find(io::File* file, bool lazy, Interpreter* interp);
+
+			/// writes module as the entry of file. It is written next to the
+			/// entry and renamed over it, so a reader never sees half an entry.
+			void store(io::File* file, bool lazy, ast::Module* module, Interpreter* interp);
+
+			/// the hits, misses and writes so far.
+			void report(std::ostream& out);
+
+		private:
+			std::string entry(io::File* file, bool lazy);
+
+			std::string dir;
+			bool usable{false};				// the directory exists
+			std::atomic<u32> hits{0};
+			std::atomic<u32> misses{0};
+			std::atomic<u32> stores{0};
+	};
+}
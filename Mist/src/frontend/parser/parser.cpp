@@ -7,18 +7,24 @@ How to handle newlines in the middle of an expression?
 
 #include <cstdarg>
 #include "interpreter.hpp"
+#include "tokenizer/literal.hpp"
 #include "ast/ast_decl.hpp"
 #include "ast/ast_expr.hpp"
 #include "ast/ast_typespec.hpp"
-#include "ast/ast_printer.hpp"
+#include "ast/ast_shift.hpp"
+#include "utils/thread_pool.hpp"
 
-// REMOVE ME!!!
-#include <bitset>
-#include <iostream>
+#include "utils/trace.hpp"
+
+// a trace event about token t.
+#define TRACE_TOKEN(level, name, t) MIST_TRACE(level, name, (t).get_string(), token_pos(t).offset, (u32) (t).kind())
 
 namespace mist {
+	// below two ranges of tokens a module is parsed on the calling thread.
+	static constexpr u32 MinRange = 1 << 14;
+
 	Parser::Parser(mist::Interpreter* interp) : interp(interp), file(nullptr),
-		scanner(new Scanner(interp)), curr(Tkn_Error, Pos()) {
+		scanner(new Scanner(interp)), curr(Tkn_Error, 0, 0) {
 	}
 // for now these arent different. They probabily will // later.
 	ast::Module* Parser::parse_root(io::File* file) {
@@ -26,7 +32,7 @@ namespace mist {
 	}
 
 	ast::Module* Parser::parse_module(io::File* file) {
-		std::cout << "Parsing module" << std::endl;
+		MIST_TRACE(trace::Info, "parse module", file ? file->name().c_str() : nullptr, 0, 0);
 		this->file = file;
 		reset();
 
@@ -35,100 +41,403 @@ namespace mist {
 		// std::cout << e << std::endl;
 		// ast::print(std::cout, e);
 
-		auto module = new ast::Module(file);
+		module = new ast::Module(file);
+		owner = module;
+
+		// blank lines and comments before the first declaration.
+		remove_newlines();
+
+		if(!parse_parallel())
+			parse_decls(tokens->size());
+
+		if(lazyBodies)
+			module->interp = interp;
+		return module;
+	}
+
+	ast::Module* Parser::parse_module(io::File* file, ParseState& state) {
+		state.segments.clear();
+		state.lazy = lazyBodies;
+		segments = &state.segments;
+		auto module = parse_module(file);
+		segments = nullptr;
+		state.tokens = std::move(buffer);
+		tokens = &buffer;
+		return module;
+	}
+
+	// A top level declaration is parsed the same wherever it is in the file,
+	// so one whose tokens the edit left alone parses to the same nodes. The
+	// kept declarations are walked in order with the cursor: one that starts
+	// where the cursor is is taken as it is, anything before it is parsed
+	// again, and one the new declarations ran over is dropped.
+	ast::Module* Parser::reparse_module(ast::Module* module, ParseState& state, const Scanner::Edit& edit) {
+		MIST_TRACE(trace::Info, "reparse module", module->file->name().c_str(), 0, (u32) edit.text.size());
+		file = module->file;
+		owner = module;
+		lazyBodies = state.lazy;
+
+		u32 base = interp->sources().base(file);
+		u64 size = file->size();
+		auto relex = scanner->relex(file, std::move(state.tokens), edit);
+		state.tokens = std::move(relex.tokens);
+
+		// old tokens [first, last) were replaced, those after moved by count.
+		u32 first = relex.first;
+		u32 last = relex.first + relex.removed;
+		i64 count = (i64) relex.inserted - (i64) relex.removed;
+		// how far the text after the edit moved in the file, and the file in the address space.
+		i64 text = (i64) file->size() - (i64) size;
+		i64 moved = (i64) interp->sources().base(file) - (i64) base;
+
+		// the token the edit changed next to a declaration may have ended it differently.
+		auto kept = [first, last](const ParseState::Segment& segment) {
+			return segment.decl && segment.clean && (segment.end < first || segment.begin > last);
+		};
+
+		std::vector<ParseState::Segment> old = std::move(state.segments);
+		state.segments.clear();
+		segments = &state.segments;
+		module->toplevelDeclarations.clear();
+
+		if(old.empty() || first <= old.front().begin) {
+			resume(&state.tokens, module, 0, Default);
+			remove_newlines();
+		}
+		else
+			resume(&state.tokens, module, old.front().begin, Default);
+
+		u64 i = 0;
+		while(current().kind() != Tkn_Eof) {
+			if(i < old.size() && !kept(old[i])) {
+				++i;
+				continue;
+			}
+
+			if(i < old.size()) {
+				auto segment = old[i];
+				bool after = segment.begin > last;
+				u32 begin = after ? (u32) (segment.begin + count) : segment.begin;
+				if(begin < cursor) {
+					++i;
+					continue;
+				}
+				if(begin == cursor) {
+					if(after)
+						ast::shift(segment.decl, moved + text, text);
+					else
+						ast::shift(segment.decl, moved, 0);
+					module->add_decl(segment.decl);
+					segment.begin = begin;
+					segment.end = after ? (u32) (segment.end + count) : segment.end;
+					state.segments.push_back(segment);
+					cursor = segment.end;
+					curr = tokens->get(cursor);
+					++i;
+					continue;
+				}
+			}
+
+			// one declaration and the newlines after it.
+			parse_decls(cursor + 1);
+		}
+
+		segments = nullptr;
+		tokens = &buffer;
+		this->module = nullptr;
+		return module;
+	}
+
+	void Parser::parse_decls(u32 end) {
 		//// while we are not at the end of the file.
 		//// Try to parse a new declaration
-		while(current().kind() != mist::Tkn_Eof) {
+		while(cursor < end && current().kind() != mist::Tkn_Eof) {
+			u32 begin = cursor;
+			u32 errors = Interpreter::error_count();
 			auto d = parse_toplevel_decl();
 			if(d)
 				module->add_decl(d);
 			else {
-				interp->report_error(current().pos(), "failed to find top level declaration");
+				interp->report_error(token_pos(current()), "failed to find top level declaration");
 				sync();
 			}
 			// this removes the newlines between top level declarations.
 			while(allow(Tkn_NewLine))
-				std::cout << "Removing unused new line" << std::endl;
+				TRACE_TOKEN(trace::Verbose, "skip newline", current());
+
+			if(segments)
+				segments->push_back(ParseState::Segment{begin, cursor, d, Interpreter::error_count() == errors});
 		}
+	}
 
-		return module;
+	// Top level declarations begin on a new line outside of any brackets, so
+	// the file is cut there into a few ranges per job and each range is
+	// parsed on its own parser into its own arena. The ranges are only kept
+	// if each one stopped exactly where the next begins: every range then
+	// started where the sequential parse would have, so the declarations and
+	// the errors are the same.
+	bool Parser::parse_parallel() {
+		u32 jobs = interp->jobs();
+		u32 remaining = tokens->size() - cursor;
+		if(jobs <= 1 || remaining < 2 * MinRange)
+			return false;
+
+		auto bounds = split_decls(cursor, std::max(MinRange, remaining / (jobs * 4)));
+		if(bounds.size() < 3)
+			return false;
+
+		std::vector<Range> ranges;
+		std::vector<Parser*> workers;
+		for(u64 i = 0; i + 1 < bounds.size(); ++i) {
+			ranges.emplace_back(bounds[i], bounds[i + 1]);
+			ranges.back().module = new ast::Module(file);
+			workers.push_back(interp->get_parser());
+		}
+
+		interp->workers().parallel_for((u32) ranges.size(), [&ranges, &workers, this](u32 i) {
+			workers[i]->parse_range(this, ranges[i]);
+		});
+
+		for(auto worker : workers)
+			interp->close_parser(worker);
+
+		bool matched = std::all_of(ranges.begin(), ranges.end(), [](const Range& range) {
+			return range.stop == range.end;
+		});
+
+		for(auto& range : ranges) {
+			if(matched) {
+				interp->print_errors(range.diagnostics);
+				module->arena.adopt(range.module->arena);
+				for(auto d : range.module->toplevelDeclarations)
+					module->add_decl(d);
+				if(segments)
+					segments->insert(segments->end(), range.segments.begin(), range.segments.end());
+			}
+			delete range.module;
+		}
+
+		if(matched) {
+			cursor = bounds.back();
+			curr = tokens->get(cursor);
+		}
+		return matched;
+	}
+
+	std::vector<u32> Parser::split_decls(u32 first, u32 size) {
+		std::vector<u32> bounds = {first};
+		u32 last = tokens->size() - 1;
+		u32 depth = 0;
+		for(u32 i = first; i < last; ++i) {
+			switch(tokens->kind(i)) {
+				case Tkn_OpenParen:
+				case Tkn_OpenBrace:
+				case Tkn_OpenBracket:
+					++depth;
+					break;
+				case Tkn_CloseParen:
+				case Tkn_CloseBrace:
+				case Tkn_CloseBracket:
+					if(depth > 0)
+						--depth;
+					break;
+				case Tkn_Identifier:
+					// only 'name ::' is taken as a start, anything else could continue a line.
+					if(depth == 0 && i - bounds.back() >= size && tokens->kind(i - 1) == Tkn_NewLine &&
+						tokens->kind(i + 1) == Tkn_ColonColon)
+						bounds.push_back(i);
+					break;
+				default:
+					break;
+			}
+		}
+		// the last range is not left much smaller than the others.
+		if(bounds.size() > 1 && last - bounds.back() < size / 2)
+			bounds.pop_back();
+		bounds.push_back(last);
+		return bounds;
+	}
+
+	void Parser::parse_range(Parser* parent, Range& range) {
+		file = parent->file;
+		owner = parent->module;
+		lazyBodies = parent->lazyBodies;
+		segments = parent->segments ? &range.segments : nullptr;
+		resume(parent->tokens, range.module, range.begin, Default);
+
+		interp->capture_errors(&range.diagnostics);
+		parse_decls(range.end);
+		interp->capture_errors(nullptr);
+
+		range.stop = cursor;
+		module = nullptr;
+		segments = nullptr;
+	}
+
+	void Parser::resume(const mist::TokenBuffer* tokens, ast::Module* module, u32 index, Restriction res) {
+		this->tokens = tokens;
+		this->module = module;
+		this->res = res;
+		operators.clear();
+		cursor = index;
+		curr = tokens->get(cursor);
+	}
+
+	ast::LazyBody* Parser::skip_body() {
+		// past the closing '}' a newline must end the declaration, so the
+		// parse could not have gone on with the body as an operand.
+		if(!lazyBodies || !check(Tkn_OpenBracket) || (res & IgnoreNewline))
+			return nullptr;
+
+		u32 last = tokens->size() - 1;
+		u32 depth = 0;
+		u32 index = cursor;
+		for(; index < last; ++index) {
+			auto kind = tokens->kind(index);
+			if(kind == Tkn_OpenBracket)
+				++depth;
+			else if(kind == Tkn_CloseBracket && --depth == 0)
+				break;
+		}
+		if(index >= last || (tokens->kind(index + 1) != Tkn_NewLine && tokens->kind(index + 1) != Tkn_Eof))
+			return nullptr;
+
+		// only the text of the body is kept, it is lexed again when it is needed.
+		auto lazy = make<ast::LazyBody>(owner, tokens->starts[cursor], tokens->starts[index] + tokens->spans[index], res);
+		cursor = next_index(index);
+		curr = tokens->get(cursor);
+		return lazy;
 	}
 
+	// Bodies of one module are parsed one at a time, they all go into its arena.
+	ast::Expr* Parser::parse_lazy_body(ast::LazyBody* lazy, std::atomic<ast::Expr*>& parsed) {
+		auto module = lazy->module;
+		std::lock_guard<std::mutex> lock(module->mutex);
+		if(lazy->done)
+			return parsed.load(std::memory_order_acquire);
+
+		auto interp = module->interp;
+		Scanner scanner(interp);
+		auto tokens = scanner.lex_range(module->file, lazy->begin, lazy->end);
+
+		auto p = interp->get_parser();
+		p->file = module->file;
+		p->owner = module;
+		p->lazyBodies = false;
+		p->resume(&tokens, module, 0, lazy->res);
+
+		auto body = p->parse_expr();
+		parsed.store(body, std::memory_order_release);
+		lazy->done = true;
+
+		p->tokens = &p->buffer;
+		p->module = nullptr;
+		interp->close_parser(p);
+		return body;
+	}
 
 	void Parser::reset() {
 		// this needs to through an error
 		if (!file) return;
 
-		scanner->init(file);
-
-		// get the first token.
-		scanner->advance();
-		curr = scanner->token();
-		scanner->advance();
+		// the whole file is lexed up front.
+		buffer = scanner->tokenize(file);
+		tokens = &buffer;
+		cursor = 0;
+		curr = tokens->get(cursor);
 	}
 
 	ast::Expr* Parser::parse_expr() {
 		return parse_accoc_expr(1);
 	}
 
+	// Operators waiting for their right operand are kept on an explicit stack
+	// instead of recursing once per precedence level, so a long chain of
+	// operators costs neither C++ stack nor calls. An operator on the stack
+	// is applied once the next operator binds less tightly, or equally
+	// tightly and is left associative.
 	ast::Expr* Parser::parse_accoc_expr(i32 prec) {
-		auto expr = parse_primary_expr();
-		std::cout << __FUNCTION__ << " " << current() << std::endl;
+		auto expr = parse_operand();
+		TRACE_TOKEN(trace::Verbose, "parse_accoc_expr", current());
 
-		if(check(Tkn_Comma) && ((res & StopAtComma) == 0)) {
-			std::vector<ast::Expr*> lvalues = { expr };
-			auto pos = expr->pos();
-			while (check(mist::Tkn_Comma)) {
-				pos = pos + current().pos();
-				advance();
-				lvalues.push_back(parse_expr_with_res(NoStructLiterals | StopAtComma));
-				pos = pos + lvalues.back()->pos();
-			}
+		auto base = operators.size();
+		while(current().prec() >= prec) {
 			auto token = current();
+			i32 curr_prec = token.prec();
+			while(operators.size() > base && (operators.back().prec > curr_prec ||
+				(operators.back().prec == curr_prec && token.acc() != mist::Right)))
+				expr = apply_operator(expr);
 
-			pos = pos + token.pos();
+			advance();
+			TRACE_TOKEN(trace::Verbose, "operator", token);
 
-			if(!token.is_assignment()) {
-				interp->report_error(current().pos(), "only assignment operators are allowed, found: %s",
-					current().get_string().c_str());
+			if(!token.is_operator() && !token.is_assignment() && token.kind() != Tkn_Dollar) {
+				interp->report_error(token_pos(current()), "expecting binary or assignement assignment, found: %s", token.get_string());
 			}
-			advance();
-			auto rhs = parse_expr();
-			pos = pos + rhs->pos();
-			return new ast::AssignmentExpr((ast::AssignmentOp) (token.kind() - mist::Tkn_Equal), lvalues, rhs, pos);
-		}
 
-		while(current().prec() >= prec) {
-			auto token = current();
-			i32 curr_prec = current().prec();
-			advance();
-			std::cout << "Current Token: " << token << " - " << current() << std::endl;
-			if (curr_prec < prec) {
-				std::cout << "Breaking from binary parsing" << std::endl;
+			operators.push_back(Operator{expr, token, curr_prec});
+			expr = parse_operand();
+			if(!expr) {
+				expr = operators.back().lhs;
+				operators.pop_back();
 				break;
 			}
+		}
 
-			if(!token.is_operator() && !token.is_assignment()) {
-				interp->report_error(current().pos(), "expecting binary or assignement assignment, found: %s", token.get_string().c_str());
-			}
+		while(operators.size() > base)
+			expr = apply_operator(expr);
+		return expr;
+	}
 
-			auto rhs = parse_accoc_expr(curr_prec + 1);
-			if(!rhs) return expr;
-			auto pos = expr->pos() + token.pos() + rhs->pos();
-			if(token.is_operator() && !token.is_assignment()) {
-				if(expr->kind() == ast::Assignment) {
-					interp->report_error(expr->pos(), "invalid sub expression of binary operator");
-				}
-				ast::BinaryOp op = (ast::BinaryOp) (token.kind() - mist::Tkn_Plus);
-				expr = new ast::BinaryExpr(op, expr, rhs, pos);
-			}
-			else {
-				ast::AssignmentOp op = (ast::AssignmentOp) (token.kind() - mist::Tkn_Equal);
-				expr = new ast::AssignmentExpr(op, {expr}, rhs, pos);
-			}
+	ast::Expr* Parser::parse_operand() {
+		auto expr = parse_primary_expr();
+		if(!expr || !check(Tkn_Comma) || (res & StopAtComma) != 0)
+			return expr;
+
+		std::vector<ast::Expr*> lvalues = { expr };
+		auto pos = expr->pos();
+		while (check(mist::Tkn_Comma)) {
+			pos = pos + token_pos(current());
+			advance();
+			lvalues.push_back(parse_expr_with_res(NoStructLiterals | StopAtComma));
+			if(lvalues.back())
+				pos = pos + lvalues.back()->pos();
 		}
+		auto token = current();
 
-		return expr;
+		pos = pos + token_pos(token);
+
+		if(!token.is_assignment()) {
+			interp->report_error(token_pos(current()), "only assignment operators are allowed, found: %s",
+				current().get_string());
+		}
+		advance();
+		// the errors of a missing side were reported already.
+		auto rhs = parse_expr();
+		if(rhs)
+			pos = pos + rhs->pos();
+		return make<ast::AssignmentExpr>((ast::AssignmentOp) (token.kind() - mist::Tkn_Equal), list(lvalues), rhs, pos);
+	}
+
+	ast::Expr* Parser::apply_operator(ast::Expr* rhs) {
+		auto op = operators.back();
+		operators.pop_back();
+		if(!op.lhs)
+			return rhs;
+
+		auto pos = op.lhs->pos() + token_pos(op.token) + rhs->pos();
+		// f $ g $ x is f(g(x))
+		if(op.token.kind() == Tkn_Dollar)
+			return make<ast::ParenthesisExpr>(op.lhs, list<ast::Expr*>({rhs}), pos);
+		if(op.token.is_operator() && !op.token.is_assignment()) {
+			if(op.lhs->kind() == ast::Assignment) {
+				interp->report_error(op.lhs->pos(), "invalid sub expression of binary operator");
+			}
+			ast::BinaryOp bop = (ast::BinaryOp) (op.token.kind() - mist::Tkn_Plus);
+			return make<ast::BinaryExpr>(bop, op.lhs, rhs, pos);
+		}
+		ast::AssignmentOp aop = (ast::AssignmentOp) (op.token.kind() - mist::Tkn_Equal);
+		return make<ast::AssignmentExpr>(aop, list<ast::Expr*>({op.lhs}), rhs, pos);
 	}
 
 	ast::Expr* Parser::parse_expr_with_res(Restriction res) {
@@ -160,7 +469,7 @@ namespace mist {
 				advance();
 				auto e = parse_primary_expr();
 				if(!e) return e;
-				return new ast::UnaryExpr(ast::from_token(c.kind()), e, c.position + e->p);
+				return make<ast::UnaryExpr>(ast::from_token(c.kind()), e, token_pos(c) + e->p);
 			}
 			default:
 				return parse_atomic_expr();
@@ -175,15 +484,15 @@ namespace mist {
 
 	ast::Expr* Parser::parse_bottom_expr() {
 		auto token = current();
-		std::cout << __FUNCTION__ << " " << token << std::endl;
+		TRACE_TOKEN(trace::Verbose, "parse_bottom_expr", token);
 		switch(token.kind()) {
 			case Tkn_SelfLit: {
 				advance();
-				return new ast::SelfExpr(token.pos());
+				return make<ast::SelfExpr>(token_pos(token));
 			}
 			case Tkn_Unit: {
 				advance();
-				return new ast::UnitExpr(token.pos());
+				return make<ast::UnitExpr>(token_pos(token));
 			}
 			case Tkn_OpenParen: {
 				advance();
@@ -191,23 +500,23 @@ namespace mist {
 				if(!expr) return expr;
 				if(check(Tkn_Comma)) {
 					std::vector<ast::Expr*> exprs;
-					auto pos = token.pos();
+					auto pos = token_pos(token);
 					while(Tkn_Comma) {
-						pos = pos + current().pos();
+						pos = pos + token_pos(current());
 						advance();
 						exprs.push_back(parse_expr());
 						pos = pos + exprs.back()->pos();
 					}
 					// the close paren
-					pos = pos + current().pos();
-					expr = new ast::TupleExpr(exprs, pos);
+					pos = pos + token_pos(current());
+					expr = make<ast::TupleExpr>(list(exprs), pos);
 				}
 				expect(Tkn_CloseParen);
 				return expr;
 			}
 			case Tkn_OpenBrace:
 				// array or map literal.
-				interp->report_error(current().pos(), "array literal not implemented");
+				interp->report_error(token_pos(current()), "array literal not implemented");
 				break;
 			case Tkn_Identifier: {
 				return parse_value();
@@ -216,69 +525,27 @@ namespace mist {
 				auto token = current();
 				advance();
 				auto cty = ast::ConstantType::I32;
-				if (check(Tkn_Identifier)) {
-					auto value = token.ident->value->val;
-					if(value == "i8")
-						cty = ast::ConstantType::I8;
-					else if(value == "i16")
-						cty = ast::ConstantType::I16;
-					else if(value == "i32")
-						cty = ast::ConstantType::I32;
-					else if(value == "i64")
-						cty = ast::ConstantType::I64;
-					else if(value == "u8")
-						cty = ast::ConstantType::U8;
-					else if(value == "u16")
-						cty = ast::ConstantType::U16;
-					else if(value == "u32")
-						cty = ast::ConstantType::U32;
-					else if(value == "u64")
-						cty = ast::ConstantType::U64;
-					else if (value == "f32")
-						cty = ast::ConstantType::F32;
-					else if (value == "f64")
-						cty = ast::ConstantType::F64;
-					else if(value == "char")
-						cty = ast::ConstantType::Char;
-				}
-				return new ast::IntegerConstExpr(token.integer, cty, token.pos());
+				if (token.suffix())
+					cty = (ast::ConstantType) (token.suffix() - 1);
+				return make<ast::IntegerConstExpr>(tokens->integer(token), cty, token_pos(token));
 			} break;
 			case Tkn_FloatLiteral: {
 				auto token = current();
 				advance();
 				auto cty = ast::ConstantType::F32;
-				if (check(Tkn_Identifier)) {
-					auto value = token.ident->value->val;
-					if (value == "f64")
-						cty = ast::ConstantType::F64;
-					else if(value == "i8")
-						cty = ast::ConstantType::I8;
-					else if(value == "i16")
-						cty = ast::ConstantType::I16;
-					else if(value == "i32")
-						cty = ast::ConstantType::I32;
-					else if(value == "i64")
-						cty = ast::ConstantType::I64;
-					else if(value == "u8")
-						cty = ast::ConstantType::U8;
-					else if(value == "u16")
-						cty = ast::ConstantType::U16;
-					else if(value == "u32")
-						cty = ast::ConstantType::U32;
-					else if(value == "u64")
-						cty = ast::ConstantType::U64;
-				}
-				return new ast::FloatConstExpr(token.floating, cty, token.pos());
+				if (token.suffix())
+					cty = (ast::ConstantType) (token.suffix() - 1);
+				return make<ast::FloatConstExpr>(tokens->floating(token), cty, token_pos(token));
 			} break;
 			case Tkn_StringLiteral: {
 				auto token = current();
 				advance();
-				return new ast::StringConstExpr(token.str, token.pos());
+				return make<ast::StringConstExpr>(string_literal(token), token_pos(token));
 			} break;
 			case Tkn_CharLiteral: {
 				auto token = current();
 				advance();
-				return new ast::CharConstExpr(token.character, token.pos());
+				return make<ast::CharConstExpr>(tokens->character(token), token_pos(token));
 			} break;
 			case Tkn_OpenBracket:
 				return parse_block();
@@ -289,7 +556,7 @@ namespace mist {
 	}
 
 	ast::Expr* Parser::parse_block() {
-		auto pos = current().pos();
+		auto pos = token_pos(current());
 		expect(Tkn_OpenBracket);
 
 		/*
@@ -307,30 +574,39 @@ namespace mist {
 		if(check(Tkn_NewLine))
 			advance();
 		std::vector<ast::Expr*> elements;
+		u32 reported = ~0u;		// the token last reported, it is reported once
 		while(!check(Tkn_CloseBracket)) {
 			if(check(Tkn_Eof)) {
-				interp->report_error(current().pos(), "found end of file instead of '}'");
+				interp->report_error(token_pos(current()), "found end of file instead of '}'");
 				return nullptr;
 			}
+			u32 start = cursor;
 			auto e = parse_expr();
 			if(e) {
 				pos = pos + e->pos();
 				elements.push_back(e);
 			}
 			if(check(Tkn_NewLine)) {
-				pos = pos + current().pos();
+				pos = pos + token_pos(current());
 				advance();
 			}
-			else interp->report_error(current().pos(), "expecting new line at end of expression, found: %s", current().get_string().c_str());
+			else {
+				if(cursor != reported)
+					interp->report_error(token_pos(current()), "expecting new line at end of expression, found: %s", current().get_string());
+				reported = cursor;
+				// the token no expression starts with is skipped, or this would see it again.
+				if(cursor == start)
+					advance();
+			}
 		}
-		pos = pos + current().pos();
+		pos = pos + token_pos(current());
 		expect(Tkn_CloseBracket);
 
-		return new ast::BlockExpr(elements, pos);
+		return make<ast::BlockExpr>(list(elements), pos);
 	}
 
 	ast::Expr* Parser::parse_suffix_expr(ast::Expr* already_parsed) {
-		std::cout << __FUNCTION__ << " " << current() << std::endl;
+		TRACE_TOKEN(trace::Verbose, "parse_suffix_expr", current());
 		auto token = current();
 		auto expr = already_parsed;
 		if(!expr) return nullptr;
@@ -340,13 +616,13 @@ namespace mist {
 		while(running) {
 			switch(current().kind()) {
 				case Tkn_Period:
-					pos = pos + current().pos();
+					pos = pos + token_pos(current());
 					advance();
 					expr = parse_dot_suffix(expr, pos);
 					if(!expr) return nullptr;
 					break;
 				case Tkn_OpenParen:
-					pos = pos + current().pos();
+					pos = pos + token_pos(current());
 					advance();
 					expr = parse_call(expr, pos);
 					expect(Tkn_CloseParen, "expecting ')' following call");
@@ -360,22 +636,22 @@ namespace mist {
 	}
 
 	ast::Expr* Parser::parse_dot_suffix(ast::Expr* operand, mist::Pos pos) {
-		std::cout << __FUNCTION__ << " " << current() << std::endl;
+		TRACE_TOKEN(trace::Verbose, "parse_dot_suffix", current());
 		if(check(Tkn_Identifier)) {
 			auto element = parse_value();
 			if(!element) {
-				interp->report_error(current().pos(), "expecting name following period, found: %s", current().get_string().c_str());
+				interp->report_error(token_pos(current()), "expecting name following period, found: %s", current().get_string());
 				return operand;
 			}
-			return new ast::SelectorExpr(operand, static_cast<ast::ValueExpr*>(element), pos + element->pos());
+			return make<ast::SelectorExpr>(operand, static_cast<ast::ValueExpr*>(element), pos + element->pos());
 		}
 		else if(check(Tkn_IntLiteral)) {
 			auto token = current();
 			advance();
-			return new ast::TupleIndexExpr(operand, (i32) token.integer, pos + token.pos());
+			return make<ast::TupleIndexExpr>(operand, (i32) tokens->integer(token), pos + token_pos(token));
 		}
 		else {
-			interp->report_error(current().pos(), "expecting an identifier or integer literal, found: %s", current().get_string().c_str());
+			interp->report_error(token_pos(current()), "expecting an identifier or integer literal, found: %s", current().get_string());
 			sync();
 			return nullptr;
 		}
@@ -387,25 +663,25 @@ namespace mist {
 			if (check(Tkn_CloseParen)) break;
 
 			if (check(Tkn_Identifier) && peek().kind() == Tkn_Colon) {
-				auto name = current().ident;
+				auto name = make_ident(current());
 				auto lpos = name->pos;
 				advance();
-				lpos = lpos + current().pos();
+				lpos = lpos + token_pos(current());
 				expect(Tkn_Colon);
 				auto expr = parse_expr_with_res(StopAtComma);
 				if (!expr) {
-					interp->report_error(current().pos(), "expecting expression in binding");
+					interp->report_error(token_pos(current()), "expecting expression in binding");
 					sync();
 					return operand;
 				}
 				lpos = lpos + expr->pos();
 				pos = pos + lpos;
-				params.push_back(new ast::BindingExpr(name, expr, lpos));
+				params.push_back(make<ast::BindingExpr>(name, expr, lpos));
 			}
 			else {
 				auto e = parse_expr_with_res(StopAtComma);
 				if (!e) {
-					interp->report_error(current().pos(), "expecting expression following comma");
+					interp->report_error(token_pos(current()), "expecting expression following comma");
 					sync();
 					return operand;
 				}
@@ -416,7 +692,7 @@ namespace mist {
 				advance();
 			}
 		}
-		return new ast::ParenthesisExpr(operand, params, pos);
+		return make<ast::ParenthesisExpr>(operand, list(params), pos);
 	}
 
 	ast::Expr* Parser::parse_value() {
@@ -424,7 +700,7 @@ namespace mist {
 		auto pos = ident->pos;
 		std::vector<ast::Expr*> params;
 		if(check(Tkn_OpenBrace)) {
-			pos = pos + current().pos();
+			pos = pos + token_pos(current());
 			advance();
 			bool has_comma = false;
 			while(!check(Tkn_CloseBrace) || has_comma) {
@@ -432,7 +708,7 @@ namespace mist {
 				// the validity of theses expressions will be validated in the type checker.
 				auto e = parse_expr_with_res(NoStructLiterals | StopAtComma);
 				if(!e) {
-					interp->report_error(current().pos(), "expecting expression in generic parameters");
+					interp->report_error(token_pos(current()), "expecting expression in generic parameters");
 					sync();
 					return  nullptr;
 				}
@@ -448,46 +724,47 @@ namespace mist {
 
 			if(!check(Tkn_CloseBrace)) {
 				if(current_can_begin_expression()) {
-					interp->report_error(current().pos(), "expecting ',' between generics parameters, found: %s", current().get_string().c_str());
+					interp->report_error(token_pos(current()), "expecting ',' between generics parameters, found: %s", current().get_string());
 				}
 			}
 			expect(Tkn_CloseBrace);
 		}
-		return new ast::ValueExpr(ident, params, pos);
+		return make<ast::ValueExpr>(ident, list(params), pos);
 	}
 
 	ast::Expr* Parser::try_parse_decl() {
 		if(check_decl_from_expr()) {
-			auto decl = parse_decl();
-			return new ast::DeclExpr(decl);
+			// a declaration that failed was reported, what follows is parsed as an expression.
+			if(auto decl = parse_decl())
+				return make<ast::DeclExpr>(decl);
 		}
 		return nullptr;
 	}
 
 	ast::Decl* Parser::parse_decl() {
-		std::cout << __FUNCTION__ << " " << current() << std::endl;
+		TRACE_TOKEN(trace::Debug, "parse_decl", current());
 		auto name = current();
 		if(peek().kind() == Tkn_Comma) {
 			std::vector<ast::Ident*> names;
-			auto pos = current().pos();
-			names.push_back(current().ident);
+			auto pos = token_pos(current());
+			names.push_back(make_ident(current()));
 			advance();
 			while(check(Tkn_Comma)) {
 				advance();
 				if(check(Tkn_Identifier)) {
-					names.push_back(current().ident);
-					pos = pos + current().pos();
+					names.push_back(make_ident(current()));
+					pos = pos + token_pos(current());
 					advance();
 				}
 				else {
-					interp->report_error(current().pos(), "expecting identifier following comma, found: '%s", current().get_string().c_str());
+					interp->report_error(token_pos(current()), "expecting identifier following comma, found: '%s", current().get_string());
 				}
 			}
 			return parse_local_decl(names, pos);
 		}
 		else {
-			auto name = current().ident;
 			if(check(Tkn_Identifier)) {
+				auto name = make_ident(current());
 				expect(Tkn_Identifier);
 				switch(current().kind()) {
 					case Tkn_Colon:
@@ -502,7 +779,7 @@ namespace mist {
 				}
 			}
 			else {
-				ast::Op op;
+				ast::Op op = ast::OpUnknown;
 				auto token = current();
 				switch(token.kind()) {
 					case Tkn_Plus:
@@ -567,7 +844,7 @@ namespace mist {
 						if(check(Tkn_CloseParen))
 							op = ast::OpParenthesis;
 						else {
-							interp->report_error(current().pos(), "expecting ')' following '('");
+							interp->report_error(token_pos(current()), "expecting ')' following '('");
 						}
 						break;
 					default:
@@ -597,7 +874,7 @@ namespace mist {
 				if(spec)
 					specs.push_back(spec);
 				else {
-					interp->report_error(current().pos(), "expecting type specification following ','");
+					interp->report_error(token_pos(current()), "expecting type specification following ','");
 					return nullptr;
 				}
 
@@ -622,7 +899,7 @@ namespace mist {
 				if(expr)
 					exprs.push_back(expr);
 				else {
-					interp->report_error(current().pos(), "expecting expression following ','");
+					interp->report_error(token_pos(current()), "expecting expression following ','");
 					return nullptr;
 				}
 
@@ -637,12 +914,10 @@ namespace mist {
 
 		if(names.size() > 1) {
 			// this is for multiple local declarations
-			return new ast::MultiLocalDecl(names, specs, exprs, pos);
+			return make<ast::MultiLocalDecl>(list(names), list(specs), list(exprs), pos);
 		}
 		else if(names.size() == 1) {
-			std::cout << "Num specs: " << specs.size() << std::endl;
-			for(auto x : specs)
-				ast::print(std::cout, x) << std::endl;
+			MIST_TRACE(trace::Debug, "local types", nullptr, pos.offset, (u32) specs.size());
 			if(specs.size() > 1) {
 				interp->report_error(specs[1]->p, "expecting only one type specification following a single identifer");
 			}
@@ -659,10 +934,10 @@ namespace mist {
 			if(!expr and !spec) {
 				interp->report_error(pos, "untyped variable must have intialization expression");
 			}
-			return new ast::LocalDecl(names.front(), spec, expr, pos);
+			return make<ast::LocalDecl>(names.front(), spec, expr, pos);
 		}
 
-		interp->report_error(current().pos(), "expecting one of ':', ':=', '=' found: '%s'", current().get_string().c_str());
+		interp->report_error(token_pos(current()), "expecting one of ':', ':=', '=' found: '%s'", current().get_string());
 		return nullptr;
 	}
 
@@ -679,7 +954,7 @@ namespace mist {
 
 		while(!check(Tkn_CloseBracket)) {
 			std::vector<ast::Ident*> names;
-			auto pos = current().pos();
+			auto pos = token_pos(current());
 
 			if(current().kind() != Tkn_Identifier)
 				break;
@@ -692,11 +967,11 @@ namespace mist {
 					pos = pos + names.back()->pos;
 				}
 				else {
-					interp->report_error(current().pos(), "expecting identifier following ',', found: '%s", current().get_string().c_str());
+					interp->report_error(token_pos(current()), "expecting identifier following ',', found: '%s", current().get_string());
 				}
 			}
 			auto d = (ast::FieldDecl*) parse_local_decl(names, pos);
-			ast::print(std::cout, d) << std::endl;
+			MIST_TRACE(trace::Debug, "struct field", nullptr, d ? d->pos.offset : 0, (u32) names.size());
 			if(d)
 				fields.push_back(d);
 
@@ -729,21 +1004,21 @@ namespace mist {
 				where = parse_where_clause();
 		}
 
-		return new ast::StructDecl(name, fields, derives, where, gens, name->pos);
+		return make<ast::StructDecl>(name, list(fields), list(derives), where, gens, name->pos);
 	}
 
 	ast::WhereClause* Parser::parse_where_clause() {
 		std::vector<ast::WhereElement*> elements;
-		mist::Pos tpos = current().pos();
+		mist::Pos tpos = token_pos(current());
 		tpos.span = 0;
 
 		while(true) {
 			if(check(Tkn_Identifier)) {
-				auto name = current().ident;
+				auto name = make_ident(current());
 				mist::Pos pos = name->pos;
 				advance();
 
-				pos = pos + current().pos();
+				pos = pos + token_pos(current());
 				expect(Tkn_Colon, "expecting ':' following identifier");
 
 				std::vector<ast::TypeSpec*> types;
@@ -755,7 +1030,7 @@ namespace mist {
 						pos = pos + tspec->p;
 					}
 					else {
-						interp->report_error(current().pos(), "expecting type following comma");
+						interp->report_error(token_pos(current()), "expecting type following comma");
 						break;
 					}
 					if(check(Tkn_Plus)) {
@@ -765,7 +1040,7 @@ namespace mist {
 						break;
 				}
 				tpos = tpos + pos;
-				elements.push_back(new ast::WhereElement(name, types, pos));
+				elements.push_back(make<ast::WhereElement>(name, list(types), pos));
 				if(check(Tkn_Comma)) {
 					advance();
 				}
@@ -774,14 +1049,14 @@ namespace mist {
 			else break;
 		}
 
-		return new ast::WhereClause(elements, tpos);
+		return make<ast::WhereClause>(list(elements), tpos);
 	}
 
 	std::vector<ast::TypeSpec*> Parser::parse_derive_suffix() {
 		std::vector<ast::TypeSpec*> specs;
 		auto t = parse_typespec();
 		if(!t) {
-			interp->report_error(current().pos(), "expecting type following 'derive'");
+			interp->report_error(token_pos(current()), "expecting type following 'derive'");
 			return specs;
 		}
 
@@ -792,7 +1067,7 @@ namespace mist {
 
 			auto t = parse_typespec();
 			if(!t) {
-				interp->report_error(current().pos(), "expecting type following ','");
+				interp->report_error(token_pos(current()), "expecting type following ','");
 			}
 			else
 				specs.push_back(t);
@@ -818,17 +1093,17 @@ namespace mist {
 						pos = pos + t->p;
 					}
 					else {
-						interp->report_error(current().pos(), "expecting type following "
-						"comma, found: '%s'", current().get_string().c_str());
+						interp->report_error(token_pos(current()), "expecting type following "
+						"comma, found: '%s'", current().get_string());
 					}
 				} while(allow(Tkn_Comma));
 				expect(Tkn_CloseParen);
 			}
 			if(ekind == ast::EnumStruct && types.empty()) {
-				interp->report_error(current().pos(), "empty type list in struct enum "
+				interp->report_error(token_pos(current()), "empty type list in struct enum "
 				"field");
 			}
-			return new ast::EnumMemberDecl(name, ekind, pos, types, init);
+			return make<ast::EnumMemberDecl>(name, ekind, pos, list(types), init);
 		}
 		return nullptr;
 	}
@@ -849,8 +1124,8 @@ namespace mist {
 				pos = pos + member->pos;
 			}
 			else {
-				interp->report_error(current().pos(), "expecting identifier, found: '%s'", 
-					current().get_string().c_str());
+				interp->report_error(token_pos(current()), "expecting identifier, found: '%s'", 
+					current().get_string());
 			}
 
 			if(allow(Tkn_NewLine))
@@ -860,9 +1135,9 @@ namespace mist {
 			remove_newlines();
 		}
 		res = old;
-		std::cout << "Current: " << current() << std::endl;
+		TRACE_TOKEN(trace::Debug, "enum end", current());
 		expect(Tkn_CloseBracket);
-		return new ast::EnumDecl(name, members, generics, pos);
+		return make<ast::EnumDecl>(name, list(members), generics, pos);
 	}
 
 	ast::Decl* Parser::parse_typeclass_decl(ast::Ident* name, ast::Generics* generics) {
@@ -891,7 +1166,7 @@ namespace mist {
 
 		res = old;
 
-		return new ast::TypeClassDecl(name, members, generics, pos);
+		return make<ast::TypeClassDecl>(name, list(members), generics, pos);
 	}
 
 	ast::Decl* Parser::parse_function_decl(ast::Ident* name, ast::Generics* generics) {
@@ -902,20 +1177,24 @@ namespace mist {
 		if(res & AllowNoBodyFunctions) {
 			remove_newlines();
 			if(!check(Tkn_Equal) || !check(Tkn_OpenBracket)) {
-				return new ast::FunctionDecl(name, params, returns, body, generics, name->pos);
+				return make<ast::FunctionDecl>(name, list(params), list(returns), body, generics, name->pos);
 			}
 		}
 
 		if(check(Tkn_Equal)) {
 			if(peek().kind() == Tkn_OpenBracket) {
 				// warning!!!
-				interp->report_error(peek().pos(), "remove the preceding '='");
+				interp->report_error(token_pos(peek()), "remove the preceding '='");
 			}
 			advance();
 		}
 
-		body = parse_expr();
-		return new ast::FunctionDecl(name, params, returns, body, generics, name->pos);
+		auto lazy = skip_body();
+		if(!lazy)
+			body = parse_expr();
+		auto decl = make<ast::FunctionDecl>(name, list(params), list(returns), body, generics, name->pos);
+		decl->lazy = lazy;
+		return decl;
 	}
 
 	ast::Decl* Parser::parse_opfunction_decl(ast::Op op, ast::Generics* generics) {
@@ -929,25 +1208,31 @@ namespace mist {
 		if(res & AllowNoBodyFunctions) {
 			remove_newlines();
 			if(!check(Tkn_Equal) || !check(Tkn_OpenBracket)) {
-				return new ast::OpFunctionDecl(op, params, returns, body, generics, token.pos());
+				return make<ast::OpFunctionDecl>(op, list(params), list(returns), body, generics, token_pos(token));
 			}
 		}
 
 		if(check(Tkn_Equal)) {
 			if(peek().kind() == Tkn_OpenBracket) {
 				// warning!!!
-				interp->report_error(peek().pos(), "remove the preceding '='");
+				interp->report_error(token_pos(peek()), "remove the preceding '='");
 			}
 			advance();
 		}
-		body = parse_expr();
-		if(!body) std::cout << "Failed to parse body" << std::endl;
-		return new ast::OpFunctionDecl(op, params, returns, body, generics, token.pos());
+		auto lazy = skip_body();
+		if(!lazy) {
+			body = parse_expr();
+			if(!body)
+				MIST_TRACE(trace::Debug, "body failed", nullptr, token_pos(token).offset, 0);
+		}
+		auto decl = make<ast::OpFunctionDecl>(op, list(params), list(returns), body, generics, token_pos(token));
+		decl->lazy = lazy;
+		return decl;
 	}
 
 	ast::Decl* Parser::parse_user_decl(ast::Ident* name) {
 		// this will be null if it isnt found
-		std::cout << __FUNCTION__ << " " << current() << std::endl;
+		TRACE_TOKEN(trace::Debug, "parse_user_decl", current());
 		auto gen = parse_generics();
 		switch(current().kind()) {
 			case Tkn_Struct:
@@ -978,20 +1263,20 @@ namespace mist {
 				if(gen)
 					gens.push_back(gen);
 				else {
-					interp->report_error(current().pos(), "expecting generic type declaration");
+					interp->report_error(token_pos(current()), "expecting generic type declaration");
 					break;
 				}
 			}
 
 			expect(Tkn_CloseBrace);
-			return new ast::Generics(gens);
+			return make<ast::Generics>(list(gens));
 		}
 		return nullptr;
 	}
 
 	ast::GenericDecl* Parser::parse_generic_decl() {
 		if(check(Tkn_Identifier)) {
-			auto name = current().ident;
+			auto name = make_ident(current());
 			auto pos = name->pos;
 			advance();
 			std::vector<ast::TypeSpec*> bounds;
@@ -1004,7 +1289,7 @@ namespace mist {
 						pos = pos + tspec->p;
 					}
 					else {
-						interp->report_error(current().pos(), "expecting type following comma");
+						interp->report_error(token_pos(current()), "expecting type following comma");
 						break;
 					}
 					if(check(Tkn_Plus)) {
@@ -1014,7 +1299,7 @@ namespace mist {
 						break;
 				}
 			}
-			return new ast::GenericDecl(name, bounds, pos);
+			return make<ast::GenericDecl>(name, list(bounds), pos);
 		}
 		return nullptr;
 	}
@@ -1031,9 +1316,9 @@ namespace mist {
 		do {
 			// I didnt design the ast to accomidate this. Woops
 			if(check(Tkn_SelfLit)) {
-				auto pos = current().pos();
+				auto pos = token_pos(current());
 				advance();
-				auto local = new ast::LocalDecl(nullptr, nullptr, nullptr, pos);
+				auto local = make<ast::LocalDecl>(nullptr, nullptr, nullptr, pos);
 				local->is_self = true;
 				params.push_back((ast::FieldDecl*) local);
 			}
@@ -1069,19 +1354,60 @@ namespace mist {
 	}
 
 	ast::Decl* Parser::parse_toplevel_decl() {
-		// add the parsing of use decls.
-		auto decl = parse_decl();
+		auto decl = check(Tkn_Use) ? parse_use_decl() : parse_decl();
 
 		if(allow(Tkn_NewLine)) {
 			return decl;
 		}
 
 		if(!check(Tkn_Eof)) {
-			interp->report_error(current().pos(), "expecting newline following declaration, found: '%s'", current().get_string().c_str());
+			interp->report_error(token_pos(current()), "expecting newline following declaration, found: '%s'", current().get_string());
 			return nullptr;
 		}
 		return decl;
 	}
+	ast::Decl* Parser::parse_use_decl() {
+		auto pos = token_pos(current());
+		expect(Tkn_Use);
+
+		auto path = parse_path();
+		if(!path)
+			return nullptr;
+		pos = pos + path->pos;
+
+		// use memory{alloc, free}
+		std::vector<ast::UsePath*> fields;
+		if(allow(Tkn_OpenBracket)) {
+			do {
+				auto field = parse_path();
+				if(!field) {
+					interp->report_error(token_pos(current()), "expecting name in use declaration, found: '%s'", current().get_string());
+					break;
+				}
+				fields.push_back(field);
+			} while(allow(Tkn_Comma));
+			pos = pos + token_pos(current());
+			expect(Tkn_CloseBracket);
+		}
+
+		return make<ast::UseDecl>(path->names.back(), path, list(fields), pos);
+	}
+
+	ast::UsePath* Parser::parse_path() {
+		if(!check(Tkn_Identifier))
+			return nullptr;
+
+		std::vector<ast::Ident*> names;
+		names.push_back(parse_ident());
+		auto pos = names.back()->pos;
+		while(check(Tkn_Period) && peek().kind() == Tkn_Identifier) {
+			advance();
+			names.push_back(parse_ident());
+			pos = pos + names.back()->pos;
+		}
+		return make<ast::UsePath>(list(names), pos);
+	}
+
 	ast::TypeSpec* Parser::parse_typespec() {
 		auto token = current();
 		switch(current().kind()) {
@@ -1091,9 +1417,9 @@ namespace mist {
 				advance();
 				auto t = parse_typespec();
 				if(t)
-					return new ast::PointerSpec(t, token.position + t->p);
+					return make<ast::PointerSpec>(t, token_pos(token) + t->p);
 				else
-					interp->report_error(current().pos(), "expecting type to follow '*'");
+					interp->report_error(token_pos(current()), "expecting type to follow '*'");
 				return nullptr;
 			}
 			default:
@@ -1109,32 +1435,58 @@ namespace mist {
 		}
 		auto token = current();
 		advance();
-		return token.ident;
+		return make_ident(token);
+	}
+
+	mist::Token Parser::peek(u32 k) {
+		u32 index = cursor;
+		for(; k > 0; --k)
+			index = next_index(index);
+		return tokens->get(index);
 	}
 
-	mist::Token& Parser::peek() {
-		return scanner->token();
+	u32 Parser::next_index(u32 index) {
+		// the buffer always ends with Tkn_Eof, the cursor stays on it.
+		if(index + 1 < tokens->size())
+			++index;
+		if(res & IgnoreNewline)
+			index = tokens->skip(index, Tkn_NewLine);
+		return index;
 	}
 
 	mist::Token& Parser::current() { return curr; }
 
+	mist::Pos Parser::token_pos(const mist::Token& token) {
+		return tokens->pos(token);
+	}
+
+	ast::Ident* Parser::make_ident(const mist::Token& token) {
+		// only the payload of an identifier is a symbol, the others are named by the empty name.
+		u32 symbol = token.kind() == Tkn_Identifier ? tokens->symbol(token) : 0;
+		return make<ast::Ident>(symbol, tokens->pos(token));
+	}
+
+	mist::String* Parser::string_literal(const mist::Token& token) {
+		// the span includes the quotes, an unterminated literal only has the first.
+		u32 length = token.length > 1 && file->data()[token.offset + token.length - 1] == '"' ? token.length - 2 : token.length - 1;
+		std::string_view body(file->data() + token.offset + 1, length);
+		if (!(token.flags & mist::Flag_Escapes))
+			return interp->find_literal(body);
+
+		literal.clear();
+		mist::decode_string(body, literal);
+		return interp->find_literal(literal);
+	}
+
 	void Parser::advance() {
-		if(res & IgnoreNewline) {
-			do {
-				curr = scanner->token();
-				scanner->advance();
-			} while(current().kind() == Tkn_NewLine);
-		}
-		else {
-			curr = scanner->token();
-			scanner->advance();
-		}
+		cursor = next_index(cursor);
+		curr = tokens->get(cursor);
 	}
 
 	bool Parser::one_of(std::vector<TokenKind> kind) {
 		// build the list of tokens expected
 		if(kind.empty()) {
-			std::cout << "Empty One of Token list" << std::endl;
+			TRACE_TOKEN(trace::Debug, "empty one_of", current());
 			return false;
 		}
 		std::string temp = "[";
@@ -1148,7 +1500,7 @@ namespace mist {
 		temp += "]";
 
 		return one_of(kind, "Expecting one of: %s. Found: '%s'", temp.c_str(),
-											current().get_string().c_str());
+											current().get_string());
 	}
 
 	bool Parser::check(TokenKind kind) {
@@ -1156,8 +1508,8 @@ namespace mist {
 	}
 
 	void Parser::expect(TokenKind kind) {
-		expect(kind, "Expecting: '%s', Found: '%s'", mist::Token::get_string(kind).c_str(),
-							   current().get_string().c_str());
+		expect(kind, "Expecting: '%s', Found: '%s'", mist::Token::get_string(kind),
+							   current().get_string());
 	}
 
 	bool Parser::allow(TokenKind kind) {
@@ -1222,9 +1574,8 @@ namespace mist {
 		for(auto e : expr->genericValues)
 			pos = pos + e->pos();
 
-		auto t = new ast::NamedSpec(name, new ast::GenericParameters(expr->genericValues), pos);
-		delete expr;
-		return t;
+		// the value expression stays behind in the arena.
+		return make<ast::NamedSpec>(name, make<ast::GenericParameters>(expr->genericValues), pos);
 	}
 
 	bool Parser::check_decl_from_expr() {
@@ -1238,22 +1589,16 @@ namespace mist {
 			if(p.kind() == Tkn_ColonColon)
 				return true;
 			else if(p.kind() == Tkn_Comma) {
-				auto oldState = save_state();
-				while(check(Tkn_Identifier)) {
-					advance();
-					if(!check(Tkn_Comma))
+				// a, b, c : is a declaration. Looking ahead only moves an index
+				// through the tokens, the parser itself stays where it is.
+				u32 index = cursor;
+				while(tokens->kind(index) == Tkn_Identifier) {
+					index = next_index(index);
+					if(tokens->kind(index) != Tkn_Comma)
 						break;
-					else
-						advance();
-				}
-				if(check(Tkn_Colon)) {
-					restore_state(oldState);
-					return true;
-				}
-				else {
-					restore_state(oldState);
-					return false;
+					index = next_index(index);
 				}
+				return tokens->kind(index) == Tkn_Colon;
 			}
 			else if(p.kind() == Tkn_Colon) {
 				return true;
@@ -1300,20 +1645,6 @@ namespace mist {
 
 	}
 
-	Parser::SavedState Parser::save_state() {
-		return SavedState {
-			curr,
-			res,
-			scanner->save()
-		};
-	}
-
-	void Parser::restore_state(const Parser::SavedState& state) {
-		curr = state.current;
-		res = state.res;
-		scanner->restore(state.state);
-	}
-
 	void Parser::remove_newlines() {
 		while(allow(Tkn_NewLine));
 	}
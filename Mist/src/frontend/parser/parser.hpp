@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+
 #include "tokenizer/scanner.hpp"
 #include "utils/file.hpp"
 #include "ast/ast.hpp"
@@ -15,6 +18,8 @@ namespace ast {
 	struct ValueExpr;
 	struct LocalDecl;
 	struct EnumMemberDecl;
+	struct UsePath;
+	struct LazyBody;
 	typedef LocalDecl FieldDecl;
 }
 
@@ -30,6 +35,23 @@ namespace mist {
 	static Restriction NoMultiSpecs = 1 << 5;
 	static Restriction AllowNoBodyFunctions = 1 << 6;
 
+	/// What a parse leaves behind so the module can be parsed again after an
+	/// edit: the tokens of the file and the tokens each top level
+	/// declaration was parsed from.
+	struct ParseState {
+		/// the tokens [begin, end) were parsed into decl, the newlines after it included.
+		struct Segment {
+			u32 begin;
+			u32 end;
+			ast::Decl* decl;	// nullptr when nothing could be parsed
+			bool clean;			// no errors were reported while it was parsed
+		};
+
+		TokenBuffer tokens;
+		std::vector<Segment> segments;	// in order, each begins where the last ended
+		bool lazy{false};				// bodies were skipped
+	};
+
 	class Parser {
 		public:
 			Parser(mist::Interpreter* interp);
@@ -46,12 +68,29 @@ namespace mist {
 			// needs to parse module imports.
 			ast::Module* parse_module(io::File* file);
 
+			/// the same, and keeps what reparse_module needs in state.
+			ast::Module* parse_module(io::File* file, ParseState& state);
+
+			/// Applies edit to the file of module and parses it again. Only
+			/// the tokens the edit damaged are lexed again and only the top
+			/// level declarations that hold them, or that had errors, are
+			/// parsed again; the others are kept and moved to their new
+			/// positions. The module is updated in place and its nodes stay in
+			/// its arena. state must come from the last parse of module.
+			ast::Module* reparse_module(ast::Module* module, ParseState& state, const Scanner::Edit& edit);
+
 			ast::Expr* parse_expr();
 
 			ast::Expr* parse_expr_with_res(Restriction res = Default);
 
 			ast::Expr* parse_accoc_expr(i32 prec);
 
+			// a primary expression, or a multiple assignment when a comma follows it.
+			ast::Expr* parse_operand();
+
+			// pops the top of operators and applies it to its left operand and rhs.
+			ast::Expr* apply_operator(ast::Expr* rhs);
+
 			ast::Expr* parse_primary_expr();
 
 			ast::Expr* parse_atomic_expr();
@@ -107,16 +146,80 @@ namespace mist {
 
 			ast::Decl* parse_toplevel_decl();
 
+			// use a.b.c or use a.b{c, d}
+			ast::Decl* parse_use_decl();
+
+			ast::UsePath* parse_path();
+
+			/// a run of top level declarations parsed on a worker.
+			struct Range {
+				u32 begin;						// the first token of a declaration
+				u32 end;						// the first token of the next range
+				u32 stop{0};					// where the parse of the range ended
+				ast::Module* module{nullptr};	// holds the declarations and the nodes until they are merged
+				std::vector<std::string> diagnostics;
+				std::vector<ParseState::Segment> segments;
+
+				Range(u32 begin, u32 end) : begin(begin), end(end) {}
+			};
+
+			// parses top level declarations until the cursor reaches end.
+			void parse_decls(u32 end);
+
+			// parses the rest of the file on the workers, false when it is left to parse_decls.
+			bool parse_parallel();
+
+			// the starts of ranges of at least size tokens from first on, followed by the Eof.
+			std::vector<u32> split_decls(u32 first, u32 size);
+
+			// parses range with this parser, reading the tokens of parent.
+			void parse_range(Parser* parent, Range& range);
+
+			// points the parser at index in tokens, nodes are made in module.
+			void resume(const mist::TokenBuffer* tokens, ast::Module* module, u32 index, Restriction res);
+
+			// steps over a '{' body that ends its declaration when bodies are
+			// parsed lazily, nullptr when the body has to be parsed now.
+			ast::LazyBody* skip_body();
+
+			/// parses a body skipped by skip_body, once, and stores it in parsed.
+			static ast::Expr* parse_lazy_body(ast::LazyBody* lazy, std::atomic<ast::Expr*>& parsed);
+
 			ast::TypeSpec* parse_typespec();
 
 			ast::Ident* parse_ident();
 
-			mist::Token& peek();
+			/// the token k tokens after the current one, the way advance would
+			/// reach it. Nothing is lexed, the whole file is already in tokens.
+			mist::Token peek(u32 k = 1);
 			mist::Token& current();
 
+			mist::Pos token_pos(const mist::Token& token);
+
+			// identifiers only become ast nodes once the parser uses them.
+			ast::Ident* make_ident(const mist::Token& token);
+
+			/// builds a node in the arena of the active module.
+			template <typename T, typename... Args>
+			T* make(Args&&... args) {
+				return module->arena.make<T>(std::forward<Args>(args)...);
+			}
+
+			/// moves a finished list of children into the arena of the active module.
+			template <typename T>
+			mist::Span<T> list(const std::vector<T>& elements) {
+				return module->arena.copy(elements);
+			}
+
+			// string literals are decoded from the source into the literal pool.
+			mist::String* string_literal(const mist::Token& token);
+
 			// advance the scanner to the next token and update the current.
 			void advance();
 
+			// the index advance would move to from index.
+			u32 next_index(u32 index);
+
 			bool one_of(std::vector<TokenKind> kind);
 			bool check(TokenKind kind);
 			void expect(TokenKind kind);
@@ -128,7 +231,7 @@ namespace mist {
 				auto& t = current();
 				auto elem = std::find(kind.begin(), kind.end(), t.kind());
 				if (elem == kind.end()) {
-					interp->report_error(t.pos(), msg, args...);
+					interp->report_error(token_pos(t), msg, args...);
 					return false;
 				}
 				return true;
@@ -139,7 +242,7 @@ namespace mist {
 				auto t = current();
 				advance();
 				if (t.kind() != kind)
-					interp->report_error(t.pos(), msg, args...);
+					interp->report_error(token_pos(t), msg, args...);
 			}
 
 
@@ -149,19 +252,26 @@ namespace mist {
 
 			mist::Interpreter* interp; 	// interpreter
 			io::File* file; 			// active file
+			ast::Module* module{nullptr};	// the module being parsed, owns every node
+			ast::Module* owner{nullptr};	// the module the nodes end up in, a worker parses into its own
+			bool lazyBodies{false};			// function bodies are skipped and parsed on first use
 			mist::Scanner* scanner; 	// scanner for this parser
-			mist::Token curr;		// the current token. The scanner is one ahead.
+			mist::TokenBuffer buffer;	// the tokens of the file this parser lexed
+			const mist::TokenBuffer* tokens{&buffer};	// the tokens being parsed, a worker reads those of its parent
+			std::vector<ParseState::Segment>* segments{nullptr};	// receives the declarations parse_decls parses, when it is kept
+			u32 cursor{0};				// index of the current token
+			mist::Token curr;		// the current token.
 			Restriction res = Default;
+			std::string literal;		// scratch buffer for decoding string literals
 
-			struct SavedState {
-				mist::Token current;
-				Restriction res;
-				mist::Scanner::State state;
+			// a binary operator waiting for its right operand.
+			struct Operator {
+				ast::Expr* lhs;
+				mist::Token token;
+				i32 prec;
 			};
 
-
-			SavedState save_state();
-			void restore_state(const SavedState& state);
+			std::vector<Operator> operators;	// shared by nested expressions, each uses the part above where it started
 
 			ast::TypeSpec* value_to_type(ast::ValueExpr* expr);
 
@@ -0,0 +1,117 @@
+#include "literal.hpp"
+#include "utils/simd.hpp"
+
+namespace mist {
+    namespace {
+        inline i32 hex_value(char ch) {
+            if(ch >= '0' && ch <= '9') return ch - '0';
+            if(ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+            if(ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+            return -1;
+        }
+
+        // reads exactly count hex digits, p is only moved past the valid ones.
+        inline bool read_hex(const char*& p, const char* end, u32 count, u32& value) {
+            value = 0;
+            for(u32 i = 0; i < count; ++i, ++p) {
+                i32 digit = p < end ? hex_value(*p) : -1;
+                if(digit < 0)
+                    return false;
+                value = value << 4 | (u32) digit;
+            }
+            return true;
+        }
+    }
+
+    Escape decode_escape(const char*& p, const char* end) {
+        Escape escape;
+        // consume the backslash.
+        ++p;
+        if(p >= end) {
+            escape.error = Esc_Unknown;
+            return escape;
+        }
+
+        switch(*p++) {
+            case 'a':  escape.value = 0x07; break;
+            case 'b':  escape.value = 0x08; break;
+            case 'e':  escape.value = 0x1B; break;
+            case 'f':  escape.value = 0x0C; break;
+            case 'n':  escape.value = 0x0A; break;
+            case 'r':  escape.value = 0x0D; break;
+            case 't':  escape.value = 0x09; break;
+            case 'v':  escape.value = 0x0B; break;
+            case '0':  escape.value = 0x00; break;
+            case '\\': escape.value = 0x5C; break;
+            case '\'': escape.value = 0x27; break;
+            case '"':  escape.value = 0x22; break;
+            case '?':  escape.value = 0x3F; break;
+            case 'x':
+                if(!read_hex(p, end, 2, escape.value))
+                    escape.error = Esc_MissingDigits;
+                break;
+            case 'u':
+            case 'U':
+                escape.unicode = true;
+                if(!read_hex(p, end, p[-1] == 'u' ? 4 : 8, escape.value))
+                    escape.error = Esc_MissingDigits;
+                else if(escape.value > 0x10FFFF || (escape.value >= 0xD800 && escape.value <= 0xDFFF))
+                    escape.error = Esc_InvalidCodepoint;
+                break;
+            default:
+                escape.error = Esc_Unknown;
+        }
+        return escape;
+    }
+
+    const char* escape_error_string(EscapeError error) {
+        switch(error) {
+            case Esc_None:              return "valid escape";
+            case Esc_Unknown:           return "invalid escape character";
+            case Esc_MissingDigits:     return "missing hex digits in escape";
+            case Esc_InvalidCodepoint:  return "invalid unicode code point in escape";
+        }
+        return "";
+    }
+
+    void append_utf8(std::string& out, u32 codepoint) {
+        if(codepoint < 0x80)
+            out.push_back((char) codepoint);
+        else if(codepoint < 0x800) {
+            out.push_back((char) (0xC0 | codepoint >> 6));
+            out.push_back((char) (0x80 | (codepoint & 0x3F)));
+        }
+        else if(codepoint < 0x10000) {
+            out.push_back((char) (0xE0 | codepoint >> 12));
+            out.push_back((char) (0x80 | (codepoint >> 6 & 0x3F)));
+            out.push_back((char) (0x80 | (codepoint & 0x3F)));
+        }
+        else {
+            out.push_back((char) (0xF0 | codepoint >> 18));
+            out.push_back((char) (0x80 | (codepoint >> 12 & 0x3F)));
+            out.push_back((char) (0x80 | (codepoint >> 6 & 0x3F)));
+            out.push_back((char) (0x80 | (codepoint & 0x3F)));
+        }
+    }
+
+    void decode_string(std::string_view body, std::string& out) {
+        const char* p = body.data();
+        const char* end = p + body.size();
+        out.reserve(out.size() + body.size());
+        while(p < end) {
+            // copy everything up to the next escape at once.
+            auto run = simd::find(p, end, '\\');
+            out.append(p, (size_t) (run - p));
+            if((p = run) == end)
+                break;
+
+            auto escape = decode_escape(p, end);
+            if(escape.error)
+                continue;
+            if(escape.unicode)
+                append_utf8(out, escape.value);
+            else
+                out.push_back((char) escape.value);
+        }
+    }
+}
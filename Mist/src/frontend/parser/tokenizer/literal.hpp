@@ -0,0 +1,37 @@
+#pragma once
+
+#include "common.hpp"
+#include <string>
+#include <string_view>
+
+// Escape sequences shared by character and string literals. The scanner
+// only validates them, strings are decoded when the parser asks for them.
+
+namespace mist {
+
+    enum EscapeError {
+        Esc_None,
+        Esc_Unknown,            /// the character following the backslash is not an escape
+        Esc_MissingDigits,      /// \x, \u or \U without enough hex digits
+        Esc_InvalidCodepoint,   /// a surrogate or a value above 0x10FFFF
+    };
+
+    struct Escape {
+        u32 value{0};           /// a byte, or a code point when unicode is set
+        bool unicode{false};    /// \u and \U are stored as utf-8
+        EscapeError error{Esc_None};
+    };
+
+    /// decodes the escape sequence at p, which must point at the backslash.
+    /// p is left on the first character following the escape.
+    Escape decode_escape(const char*& p, const char* end);
+
+    const char* escape_error_string(EscapeError error);
+
+    /// appends the utf-8 encoding of codepoint.
+    void append_utf8(std::string& out, u32 codepoint);
+
+    /// decodes the text between the quotes of a string literal into out.
+    /// Invalid escapes have already been reported by the scanner and are dropped.
+    void decode_string(std::string_view body, std::string& out);
+}
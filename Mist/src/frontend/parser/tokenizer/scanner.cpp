@@ -2,9 +2,36 @@
 
 #include <thread>
 #include <iostream>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cstdio>
 #include "interpreter.hpp"
+#include "utils/simd.hpp"
+#include "utils/thread_pool.hpp"
+#include "literal.hpp"
+#include "frontend/parser/ast/ast_expr.hpp"
 
 namespace mist {
+    // below two chunks a file is lexed on the calling thread.
+    static constexpr u64 MinChunk = 1 << 18;
+
+    template <typename... Args>
+    void Scanner::error(u64 offset, u64 length, const char* msg, Args... args) {
+        if(!deferred) {
+            interp->report_error(buffer.pos((u32) offset, (u32) length), msg, args...);
+            return;
+        }
+
+        // the chunk may have been lexed from the wrong state, so the message
+        // waits until the stitch knows whether the token is kept.
+        int size = std::snprintf(nullptr, 0, msg, args...);
+        std::string message(size > 0 ? (size_t) size : 0, '\0');
+        std::snprintf(&message[0], message.size() + 1, msg, args...);
+        diagnostics.push_back(Diagnostic{buffer.size(), (u32) offset, (u32) length, std::move(message)});
+    }
+
     Scanner::Scanner(Interpreter* interp) : interp(interp) {}
 
     Scanner::~Scanner() = default;
@@ -24,6 +51,246 @@ namespace mist {
 		return current;
     }
 
+    TokenBuffer& Scanner::tokens() {
+        return buffer;
+    }
+
+    TokenBuffer Scanner::tokenize(io::File* file, u64 chunkSize) {
+        init(file);
+        if(!file->is_loaded()) {
+            buffer.push(make_token(Tkn_Eof));
+            return std::move(buffer);
+        }
+
+        // large files are split over the workers, the threads cost more than they save below that.
+        u32 jobs = interp->jobs();
+        if(!chunkSize && jobs > 1 && length >= 2 * MinChunk)
+            chunkSize = std::max<u64>(MinChunk, length / (jobs * 4));
+        if(chunkSize && chunkSize < length)
+            return lex_parallel(chunkSize);
+
+        // roughly one token every four characters.
+        u64 estimate = length / 4 + 1;
+        buffer.kinds.reserve(estimate);
+        buffer.flags.reserve(estimate);
+        buffer.starts.reserve(estimate);
+        buffer.spans.reserve(estimate);
+        buffer.payloads.reserve(estimate);
+
+        do {
+            advance();
+            if(current.kind() != Tkn_Comment)
+                buffer.push(current);
+        } while(current.kind() != Tkn_Eof);
+
+        return std::move(buffer);
+    }
+
+
+    // Chunks are lexed as if they started outside of any token. That is only
+    // wrong when the last token of the previous chunk, a string or a block
+    // comment, runs into the chunk; the stitch then lexes the chunk again from
+    // where that token ended until it reaches a token start the chunk also has.
+    // Identifiers are interned and errors reported during the stitch, in the
+    // same order as lexing on one thread would, so the symbol ids do not
+    // depend on how the workers ran.
+    TokenBuffer Scanner::lex_parallel(u64 chunkSize) {
+        std::vector<Chunk> chunks;
+        for(u64 begin = 0; begin < length;) {
+            // chunks end after a newline, the last one takes the Eof token.
+            u64 end = begin + chunkSize;
+            if(end < length)
+                end = (u64) (simd::find(source + end, this->end(), '\n') - source) + 1;
+            if(end >= length)
+                end = length + 1;
+            chunks.emplace_back(begin, end);
+            begin = end;
+        }
+
+        auto file = this->file;
+        interp->workers().parallel_for((u32) chunks.size(), [&chunks, file, this](u32 i) {
+            Scanner worker(interp);
+            worker.lex_chunk(file, chunks[i]);
+        });
+
+        u64 count = 0;
+        for(auto& chunk : chunks)
+            count += chunk.tokens.size();
+        buffer.kinds.reserve(count);
+        buffer.flags.reserve(count);
+        buffer.starts.reserve(count);
+        buffer.spans.reserve(count);
+        buffer.payloads.reserve(count);
+
+        for(auto& chunk : chunks)
+            stitch(chunk);
+        return std::move(buffer);
+    }
+
+    void Scanner::lex_chunk(io::File* file, Chunk& chunk) {
+        this->file = file;
+        source = file->data();
+        length = file->size();
+        deferred = true;
+        chunked = true;
+        buffer = TokenBuffer();
+        seek(chunk.begin);
+
+        chunk.stop = chunk.begin;
+        while(next_start() < chunk.end) {
+            advance();
+            buffer.push(current);
+            chunk.stop = index;
+            if(current.kind() == Tkn_Eof)
+                break;
+        }
+
+        chunk.tokens = std::move(buffer);
+        chunk.diagnostics = std::move(diagnostics);
+    }
+
+    TokenBuffer Scanner::lex_range(io::File* file, u64 begin, u64 end) {
+        this->file = file;
+        source = file->data();
+        length = file->size();
+        deferred = true;
+        buffer = TokenBuffer(interp->sources().base(file));
+        seek(begin);
+
+        while(next_start() < end) {
+            advance();
+            if(current.kind() != Tkn_Comment)
+                buffer.push(current);
+        }
+        new_token();
+        buffer.push(make_token(Tkn_Eof));
+        diagnostics.clear();
+        return std::move(buffer);
+    }
+
+    void Scanner::stitch(Chunk& chunk) {
+        auto& guess = chunk.tokens;
+        u32 first = 0;
+
+        if(index != chunk.begin) {
+            u32 j = 0;
+            first = guess.size();
+            while(next_start() < chunk.end) {
+                advance();
+                if(current.kind() != Tkn_Comment)
+                    buffer.push(current);
+                if(current.kind() == Tkn_Eof)
+                    return;
+
+                while(j < guess.size() && guess.starts[j] < current.offset)
+                    ++j;
+                // the token was just lexed here, the chunk takes over after it.
+                if(j < guess.size() && guess.starts[j] == current.offset && guess.kind(j) == current.kind()) {
+                    first = j + 1;
+                    break;
+                }
+            }
+            if(first == guess.size())
+                return;
+        }
+
+        auto diagnostic = chunk.diagnostics.begin();
+        while(diagnostic != chunk.diagnostics.end() && diagnostic->token < first)
+            ++diagnostic;
+
+        for(u32 i = first; i < guess.size(); ++i) {
+            for(; diagnostic != chunk.diagnostics.end() && diagnostic->token == i; ++diagnostic)
+                interp->report_error(buffer.pos(diagnostic->offset, diagnostic->length), "%s", diagnostic->message.c_str());
+
+            auto token = guess.get(i);
+            switch(token.kind()) {
+                case Tkn_Comment:
+                    continue;
+                case Tkn_Identifier:
+                    token.payload = interp->intern(std::string_view(source + token.offset, token.length));
+                    break;
+                case Tkn_IntLiteral:
+                    token.payload = buffer.add_integer(guess.integer(token));
+                    break;
+                case Tkn_FloatLiteral:
+                    token.payload = buffer.add_float(guess.floating(token));
+                    break;
+                default:
+                    break;
+            }
+            buffer.push(token);
+        }
+        seek(chunk.stop);
+    }
+
+    // The scanner keeps no state between tokens, so lexing from the start of
+    // any old token reproduces the old stream until it reaches the edit. After
+    // the edit the first token that starts where an old token (moved by the
+    // edit) started and has the same kind is lexed from identical text, so
+    // every old token from there on is reused.
+    Scanner::Relex Scanner::relex(io::File* file, TokenBuffer old, const Edit& edit) {
+        u32 count = old.size();
+
+        // the token holding the edit and the two before it are lexed again,
+        // a number looks up to two characters past its end ("1.x" to "1.5").
+        u32 first = (u32) (std::upper_bound(old.starts.begin(), old.starts.end(), (u32) edit.offset) - old.starts.begin());
+        first = first >= 3 ? first - 3 : 0;
+        // comments are not kept, so lexing resumes where the last kept token ended.
+        u32 resume = first ? old.starts[first - 1] + old.spans[first - 1] : 0;
+
+        auto status = interp->sources().edit(file, edit.offset, edit.removed, edit.text);
+        if(status != io::Source_Ok) {
+            interp->report_error(old.pos((u32) std::min<u64>(edit.offset, old.starts[count - 1]), 0), "%s", io::status_message(status));
+            return Relex{std::move(old), 0, 0, 0};
+        }
+
+        this->file = file;
+        source = file->data();
+        length = file->size();
+
+        i64 shift = (i64) edit.text.size() - (i64) edit.removed;
+        u64 damage = edit.offset + edit.text.size();   // end of the inserted text
+
+        // the reused tokens keep their payloads, so the side tables carry over
+        // and the re-lexed tokens add to them. Entries of replaced tokens stay behind.
+        buffer = TokenBuffer(interp->sources().base(file));
+        buffer.integers = std::move(old.integers);
+        buffer.floats = std::move(old.floats);
+
+        // most edits leave the number of tokens about the same.
+        u64 estimate = count + edit.text.size() / 4 + 16;
+        buffer.kinds.reserve(estimate);
+        buffer.flags.reserve(estimate);
+        buffer.starts.reserve(estimate);
+        buffer.spans.reserve(estimate);
+        buffer.payloads.reserve(estimate);
+        buffer.append(old, 0, first);
+
+        seek(resume);
+
+        u32 resync = count;
+        u32 j = first;
+        do {
+            advance();
+            if(current.kind() == Tkn_Comment)
+                continue;
+
+            if(current.offset >= damage) {
+                i64 previous = (i64) current.offset - shift;
+                while(j < count && old.starts[j] < previous)
+                    ++j;
+                if(j < count && old.starts[j] == previous && old.kind(j) == current.kind()) {
+                    resync = j;
+                    break;
+                }
+            }
+            buffer.push(current);
+        } while(current.kind() != Tkn_Eof);
+
+        u32 inserted = buffer.size() - first;
+        buffer.append(old, resync, count, shift);
+        return Relex{std::move(buffer), first, resync - first, inserted};
+    }
 
     bool Scanner::init() {
 
@@ -31,13 +298,16 @@ namespace mist {
 		//std::thread loadThread([](io::File* file) {
 		//}, this->file);
 
+        buffer = TokenBuffer();
         index = 0;
-        position = mist::Pos(0, 0, 0, file->id());
+        start = 0;
 
-		if (!file->load()) {
-			interp->report_error(this->position, "Failed to load file");
+		auto status = interp->sources().load(file);
+		if (status != io::Source_Ok) {
+			interp->report_error(Pos(), "%s: %s", io::status_message(status), file->fullpath().c_str());
 			return false;
 		}
+        buffer.base = interp->sources().base(file);
 	
             
         // std::cout << "Waiting for the file to load" << std::endl;
@@ -46,52 +316,56 @@ namespace mist {
 
         // std::cout << "The file has been loaded" << std::endl;
 
-        source = &file->value();
-        currentCh = &source->at(index);
-        if(index + 1 >= source->size())
+        source = file->data();
+        length = file->size();
+        currentCh = index < length ? source + index : nullptr;
+        if(index + 1 >= length)
             nextCh = nullptr;
         else
-            nextCh = &source->at(index + 1);
+            nextCh = source + index + 1;
 		return true;
     }
 
     void Scanner::bump() {
-        if(index + 1 < source->size()) {
-            // check if the current character is a new line
-            if(check('\n')) {
-                // if so, then update the line and column count
-                position.line++;
-                position.column = 0;
-            }
-    
-            // move the current forward in the source
-            ++index;
-            ++position.span;
-            ++savePos.span;
-            ++position.column;
-    
-            // update the character pointers.
-            currentCh = &source->at(index);
-            if(index + 1 >= source->size())
-                nextCh = nullptr;
-            else
-                nextCh = &source->at(index + 1);
-        }
-        else
-            currentCh = nullptr;
+        if(!currentCh)
+            return;
+
+        // move the current forward in the source
+        ++index;
+
+        // update the character pointers, the end of the source clears them.
+        currentCh = index < length ? source + index : nullptr;
+        nextCh = index + 1 < length ? source + index + 1 : nullptr;
+    }
+
+    void Scanner::skip_to(const char* p) {
+        if(!currentCh || p == currentCh)
+            return;
+
+        index = p >= end() ? length : (u64) (p - source);
+
+        currentCh = index < length ? source + index : nullptr;
+        nextCh = index + 1 < length ? source + index + 1 : nullptr;
     }
 
 
+    void Scanner::seek(u64 offset) {
+        index = offset;
+        start = offset;
+        currentCh = index < length ? source + index : nullptr;
+        nextCh = index + 1 < length ? source + index + 1 : nullptr;
+    }
+
     Token Scanner::next_token() {
         // consumes all of the whitespace
-        while(currentCh and isspace(*currentCh) and !check('\n'))
-            bump();
+        if(currentCh)
+            skip_to(simd::skip_blanks(currentCh, end()));
        
         // initializes a new token from the currnet point in the text
         new_token();
 
 		if (!currentCh)
-			return Token(Tkn_Eof, savePos);
+			return make_token(Tkn_Eof);
 
 		if (isalpha(*this->currentCh) or check('_'))
 			return scan_identifier();
@@ -102,123 +376,173 @@ namespace mist {
     }
 
 	Token Scanner::scan_identifier() {
-        std::string temp;
-        while(currentCh && (isalnum(*currentCh) or check('_'))) {
-            temp.push_back(*currentCh);
-            bump();
-        }
+        auto first = currentCh;
+        auto stop = simd::skip_ident(currentCh, end());
+        skip_to(stop);
+        std::string_view temp(first, stop - first);
 
-        // clean up the string if it isnt used by the table
-
-        
         TokenKind kind = Token::keyword(temp);
 
         if(kind == Tkn_None) {
-			auto s = interp->find_string(temp);
-			// this is fine, Visual Studio is not detecting the constructors generated from a Macro.
-			return Token(new ast::Ident(s, savePos), savePos);
+            // a chunk may be lexed from the wrong state, the stitch interns it from the span.
+            if(chunked)
+                return make_token(Tkn_Identifier);
+			return make_token(Tkn_Identifier, interp->intern(temp));
         }
         else {
-            return Token(kind, savePos);
+            return make_token(kind);
         }
     }
 
-    Token Scanner::scan_number_literal() {
-        std::string temp;
-		if (check('0')) {
-            bump();
+    namespace {
+        inline bool is_digit(char ch) { return ch >= '0' && ch <= '9'; }
 
-			if (check('x') or
-				check('X')) {
-                bump();
-				while (currentCh && isxdigit(*currentCh)){
-                    temp.push_back(*currentCh);
-                    bump();
-                }
+        inline bool is_hex(char ch) {
+            return is_digit(ch) || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+        }
 
-				u64 val = strtoll(temp.c_str(), NULL, 16);
-				return Token(val, savePos);
-			}
-			else if (check('b') or
-                     check('B')) {
-                bump();
-				while (check('1') or
-					   check('0')) {
-                    temp.push_back(*currentCh);
-                    bump();
-                }
+        inline const char* skip_digits(const char* p, const char* end, int base) {
+            switch(base) {
+                case 2:  while(p < end && (*p == '0' || *p == '1')) ++p; break;
+                case 16: while(p < end && is_hex(*p)) ++p; break;
+                default: while(p < end && is_digit(*p)) ++p; break;
+            }
+            return p;
+        }
 
-				u64 val = strtoll(temp.c_str(), NULL, 2);
-				return Token(val, savePos);
-			}
-            else
-                temp.push_back('0');
-		}
-		bool floating_point = false;
-		bool scientific_notation = false;
-        // scan digits before the decimal point
-		while (currentCh && isdigit(*currentCh)) {
-            temp.push_back(*currentCh);
-            bump();
+        struct Suffix {
+            std::string_view name;
+            ast::ConstantType type;
+            u64 max;            /// largest value that fits, floats are checked separately
+        };
+
+        constexpr Suffix suffixes[] = {
+            {"i8",   ast::I8,   0x7F},
+            {"i16",  ast::I16,  0x7FFF},
+            {"i32",  ast::I32,  0x7FFFFFFF},
+            {"i64",  ast::I64,  0x7FFFFFFFFFFFFFFF},
+            {"u8",   ast::U8,   0xFF},
+            {"u16",  ast::U16,  0xFFFF},
+            {"u32",  ast::U32,  0xFFFFFFFF},
+            {"u64",  ast::U64,  0xFFFFFFFFFFFFFFFF},
+            {"f32",  ast::F32,  0},
+            {"f64",  ast::F64,  0},
+            {"char", ast::Char, 0xFF},
+        };
+
+        const Suffix* find_suffix(std::string_view name) {
+            for(const auto& suffix : suffixes)
+                if(suffix.name == name)
+                    return &suffix;
+            return nullptr;
         }
+    }
 
-		if (check('.') and (nextCh and *nextCh != '.')) {
-            temp.push_back(*currentCh);
-            bump();
-			while (currentCh && isdigit(*currentCh)) {
-                temp.push_back(*currentCh);
-                bump();
+    // Literals are parsed in place from the source, [first, digits) is the
+    // number and [digits, last) the suffix attached to it, if any.
+    Token Scanner::scan_number_literal() {
+        const char* first = currentCh;
+        const char* p = first;
+        const char* stop = end();
+
+        int base = 10;
+        if(p[0] == '0' && p + 1 < stop) {
+            if(p[1] == 'x' || p[1] == 'X') base = 16;
+            else if(p[1] == 'b' || p[1] == 'B') base = 2;
+        }
+
+        bool floating = false;
+        const char* number = base == 10 ? p : p + 2;
+        p = skip_digits(number, stop, base);
+
+        if(base != 10) {
+            if(p == number)
+                error(start, p - first, "missing digits after '%.2s'", first);
+            else if(base == 2 && p < stop && is_digit(*p)) {
+                error(p - source, 1, "invalid digit '%c' in binary literal", *p);
+                p = skip_digits(p, stop, 10);
             }
-			floating_point = true;
-		}
-		if (check('e') or
-			check('E')) {
-            temp.push_back(*currentCh);
-            bump();
-			if (check('-') or
-				check('+')) {
-                if(check('-'))
-                    floating_point = true;
-                temp.push_back(*currentCh);
-                bump();
+        }
+        else {
+            if(p + 1 < stop && p[0] == '.' && p[1] != '.') {
+                p = skip_digits(p + 1, stop, 10);
+                floating = true;
+            }
+            if(p < stop && (*p == 'e' || *p == 'E')) {
+                ++p;
+                if(p < stop && (*p == '-' || *p == '+'))
+                    ++p;
+                if(p == stop || !is_digit(*p))
+                    error(start, p - first, "missing exponent in float literal");
+                p = skip_digits(p, stop, 10);
+                floating = true;
             }
+        }
 
+        const char* digits = p;
+        const Suffix* suffix = nullptr;
+        if(p < stop && (isalpha(*p) || *p == '_')) {
+            p = simd::skip_ident(p, stop);
+            suffix = find_suffix(std::string_view(digits, (size_t) (p - digits)));
+            if(!suffix)
+                error(digits - source, p - digits,
+                    "invalid suffix '%.*s' on numeric literal", (int) (p - digits), digits);
+        }
+        skip_to(p);
 
+        auto span = (int) (digits - first);
+
+        if(suffix && floating && suffix->type != ast::F32 && suffix->type != ast::F64) {
+            error(start, index - start, "integer suffix '%.*s' on float literal '%.*s'",
+                (int) suffix->name.size(), suffix->name.data(), span, first);
+            suffix = nullptr;
+        }
+
+        if(suffix && base != 10 && (suffix->type == ast::F32 || suffix->type == ast::F64)) {
+            error(start, index - start, "invalid suffix '%.*s' for a %s literal '%.*s'",
+                (int) suffix->name.size(), suffix->name.data(), base == 16 ? "hex" : "binary", span, first);
+            suffix = nullptr;
+        }
+
+        // an integer with a float suffix is a float, 1f32 is 1.0f32.
+        if(suffix && !floating && (suffix->type == ast::F32 || suffix->type == ast::F64))
+            floating = true;
 
-			if (currentCh && isdigit(*currentCh))
-				while(currentCh && isdigit(*currentCh)) {
-                    temp.push_back(*currentCh);
-                    bump();
-                }
-			else {
-				// report errors
-				//scan_error(scanner->file, scanner->line, scanner->column,
-			// 		"Missing exponent in float literal\n");
-			}
-		}
-    
 		Token token;
-		if (floating_point) {
-			f64 val = strtod(temp.c_str(), NULL);
-            token = Token(val, savePos);
+		if (floating) {
+            f64 val = 0;
+            auto result = std::from_chars(first, digits, val);
+            if(result.ec == std::errc::result_out_of_range)
+                error(start, index - start, "float literal '%.*s' is out of range for f64", span, first);
+            else if(suffix && suffix->type == ast::F32 && std::fabs(val) > std::numeric_limits<f32>::max())
+                error(start, index - start, "float literal '%.*s' is out of range for f32", span, first);
+            token = make_token(Tkn_FloatLiteral, buffer.add_float(val));
 		}
 		else {
-			u64 val = strtoll(temp.c_str(), NULL, 10);
-            token = Token(val, savePos);
+            u64 val = 0;
+            auto result = std::from_chars(number, digits, val, base);
+            if(result.ec == std::errc::result_out_of_range)
+                error(start, index - start, "integer literal '%.*s' does not fit in 64 bits", span, first);
+            else if(suffix && val > suffix->max)
+                error(start, index - start, "integer literal '%.*s' does not fit in %.*s (max %llu)",
+                    span, first, (int) suffix->name.size(), suffix->name.data(), (unsigned long long) suffix->max);
+            token = make_token(Tkn_IntLiteral, buffer.add_integer(val));
 		}
+        if(suffix)
+            token.flags |= (u16) (suffix->type + 1);
 		return token;
     }
 
-#define SingleToken(ch, kind) case ch: return Token(kind, savePos);
+#define SingleToken(ch, kind) case ch: return make_token(kind);
 
 #define DoubleToken(ch, kind1, kind2) \
 	case ch: \
 		if(check('=')) { \
             bump(); \
-			return Token(kind2, savePos); \
+			return make_token(kind2); \
 		} \
 		else { \
-			return Token(kind1, savePos); \
+			return make_token(kind1); \
 		} \
 		break;
 
@@ -226,14 +550,14 @@ namespace mist {
 	case ch: \
 		if(check('=')) { \
             bump(); \
-			return Token(kind2, savePos); \
+			return make_token(kind2); \
 		} \
 		else if(check((ch))) { \
             bump(); \
-			return Token(kind3, savePos); \
+			return make_token(kind3); \
 		} \
 		else { \
-			return Token(kind1, savePos); \
+			return make_token(kind1); \
 		} \
 		break;
 
@@ -241,20 +565,20 @@ namespace mist {
 	case ch: {\
 		if(check('=')) { \
             bump(); \
-			return Token(kind2, savePos); \
+			return make_token(kind2); \
 		} \
 		else if(check((ch))) { \
             bump(); \
 			if(check('=')) { \
                 bump(); \
-                return Token(kind4, savePos); \
+                return make_token(kind4); \
 			} \
 			else { \
-                return Token(kind3, savePos); \
+                return make_token(kind3); \
 			} \
 		} \
 		else { \
-          return Token(kind1, savePos); \
+          return make_token(kind1); \
 		} \
 	} break;
 
@@ -262,7 +586,7 @@ namespace mist {
         auto ch = *currentCh;
         bump();
         switch(ch) {
-			case '\n': return Token(Tkn_NewLine, savePos);
+			case '\n': return make_token(Tkn_NewLine);
             SingleToken('(', Tkn_OpenParen);
             SingleToken(')', Tkn_CloseParen);
             SingleToken('[', Tkn_OpenBrace);
@@ -274,6 +598,7 @@ namespace mist {
             SingleToken(';', Tkn_Semicolon);
             SingleToken('_', Tkn_Underscore);
             SingleToken('#', Tkn_Hash);
+            SingleToken('$', Tkn_Dollar);
 
             DoubleToken('^', Tkn_Carrot, Tkn_CarrotEqual)
             DoubleToken('%', Tkn_Percent, Tkn_PercentEqual)
@@ -291,26 +616,26 @@ namespace mist {
             case '-': {
                     if(check('>')) {
                         bump();
-                        return Token(Tkn_MinusGreater, savePos);
+                        return make_token(Tkn_MinusGreater);
                     }
                     else
-                        return Token(Tkn_Minus, savePos);
+                        return make_token(Tkn_Minus);
                 }
 
             case '.': {
                     if(check('.')) {
                         bump();
-                        return Token(Tkn_PeriodPeriod, savePos);
+                        return make_token(Tkn_PeriodPeriod);
                     }
-                    return Token(Tkn_Period, savePos);
+                    return make_token(Tkn_Period);
                 }
             case '/': {
                     if(check('/') or check('*'))
                         return scan_comment();
                     else if(check('='))
-                        return Token(Tkn_SlashEqual, savePos);
+                        return make_token(Tkn_SlashEqual);
                     else
-                        return Token(Tkn_Slash, savePos);
+                        return make_token(Tkn_Slash);
                     }
                   case '\'': {
                             return scan_character();
@@ -322,169 +647,153 @@ namespace mist {
             case '<': {
                 if(check('=')) {
                     bump();
-                    return Token(Tkn_LessEqual, savePos);
+                    return make_token(Tkn_LessEqual);
                 }
                 else if(check('<')) {
                     bump();
                     if(check('=')) {
                         bump();
-                        return Token(Tkn_LessLessEqual, savePos);
+                        return make_token(Tkn_LessLessEqual);
                     }
                     else {
-                        return Token(Tkn_LessLess, savePos);
+                        return make_token(Tkn_LessLess);
                     }
                 }
                 else if(check('>')) {
                     bump();
-                    return Token(Tkn_Unit, savePos);
+                    return make_token(Tkn_Unit);
                 }
                 else {
-                  return Token(Tkn_Less, savePos);
+                  return make_token(Tkn_Less);
                 }
             } break;
             default:
-              std::cout << "Found unknown character: '" << ch << "'" << std::endl;
+              error(start, 1, "found unknown character: '%c'", ch);
               break;  
         }
 
-        return Token(Tkn_Error, savePos);
+        return make_token(Tkn_Error);
     }
 
     Token Scanner::scan_character() {
-        char temp;
-        if(!currentCh)  {
-            interp->report_error(position, "found end of file while expecting to find character");
+        u32 value = 0;
+        if(!currentCh) {
+            error(start, index - start, "found end of file while expecting to find character");
+            return make_token(Tkn_CharLiteral);
         }
-        switch(*currentCh) {
-            case '\\':
-                temp = validate_escape();
-                break;
-            default:
-                temp = *currentCh;
-                bump();
+        if(check('\\')) {
+            const char* p = currentCh;
+            auto escape = decode_escape(p, end());
+            if(escape.error)
+                error(index, p - currentCh, "%s: '%.*s'",
+                    escape_error_string(escape.error), (int) (p - currentCh), currentCh);
+            else if(escape.unicode && escape.value > 0x7F)
+                error(index, p - currentCh, "code point U+%04X does not fit in a char", escape.value);
+            value = escape.value & 0xFF;
+            skip_to(p);
+        }
+        else {
+            value = (u8) *currentCh;
+            bump();
+            // a multibyte utf-8 sequence is consumed whole so the literal still ends at the quote.
+            if(value >= 0x80) {
+                while(currentCh && ((u8) *currentCh & 0xC0) == 0x80)
+                    bump();
+                if(index - start > 2)
+                    error(start + 1, index - start - 1, "character literal does not fit in a char");
+            }
         }
 		if(check('\''))
 			bump();
-		else {
-			// report the error
-			std::cout << "This is an error" << std::endl;
-		}
-		// this is fine, Visual Studio is not detecting the constructors generated from a Macro.
-        return Token(temp, savePos);
+		else
+            error(start, index - start, "expecting ' to close character literal");
+        return make_token(Tkn_CharLiteral, value);
     }
 
+    // strings are not decoded here, the token is the span of the literal
+    // and the escapes are only checked so errors point into the source.
     Token Scanner::scan_string() {
-		char ch;
-        std::string temp;
-        while(currentCh and !check('"')) {
-            if(check('\\'))
-                ch = validate_escape();
-            else {
-                ch = *currentCh;
-                bump();
-            }
-    
-            temp.push_back(ch);
+        const char* stop = end();
+        const char* p = currentCh ? currentCh : stop;
+        u16 flags = 0;
+        while(true) {
+            p = simd::find_either(p, stop, '"', '\\');
+            if(p == stop || *p == '"')
+                break;
 
-			if (!currentCh)
-				std::cout << "String current character is null" << std::endl;
+            flags |= Flag_Escapes;
+            const char* first = p;
+            auto escape = decode_escape(p, stop);
+            if(escape.error)
+                error(first - source, p - first, "%s: '%.*s'",
+                    escape_error_string(escape.error), (int) (p - first), first);
         }
-        bump();
-		// this is fine, Visual Studio is not detecting the constructors generated from a Macro.
-        return Token(temp, savePos);
+
+        if(p == stop) {
+            error(start, 1, "unterminated string literal");
+            skip_to(stop);
+        }
+        else
+            skip_to(p + 1);
+
+        auto token = make_token(Tkn_StringLiteral);
+        token.flags = flags;
+        return token;
     }
     
-    /// @TODO: implement scanning for block comments and embedded block comments.
     Token Scanner::scan_comment() {
+        if(check('*'))
+            return scan_block_comment();
+
         // consume the next forward slash
 		bump();
-        std::string temp;
-		while (currentCh && !check('\n')) {
-			temp.push_back(*currentCh);
-			bump();
-		}
+        if(currentCh)
+            skip_to(simd::find(currentCh, end(), '\n'));
 
-        // takes the new line
-        bump();
-        Token token = Token(temp, savePos);
-        token.tokenKind = Tkn_Comment;
-        return token;
+        // the newline is left for the next token, it still ends the line.
+        return make_token(Tkn_Comment);
     }
 
-    char Scanner::validate_escape() {
-        if(!currentCh) {
-            interp->report_error(position, "invalid escape character at end of file");
-        }
-        bump();               // consumes the the the forward slash
-        auto ch = *currentCh; // gets the character following the forward slash.
-		bump();               // consumes it.
-        switch(ch) {
-            case 'a':
-                return 0x07;
-            case 'b':
-                return 0x08;
-            case 'f':
-                return 0x0C;
-            case 'n':
-                return 0x0A;
-            case 'r':
-                return 0x0D;
-            case 't':
-                return 0x09;
-            case 'v':
-                return 0x0B;
-            case '\\':
-                return 0x5C;
-            case '\'':
-                return 0x27;
-            case '"':
-                return 0x22;
-            case '?':
-                return 0x3F;
-          /*
-            case 'x':
-                bump();
-                while(isxdigit(curr)) bump();
-                str = cursor->substr(start);
-                pos.span = str.size();
-                return EscapeCharecterType::Hex;
-            case 'e':
-                str.push_back(0x1B);
-                return EscapeCharecterType::Character;
-            case 'U':
+    // block comments nest, /* /* */ */ is a single comment.
+    Token Scanner::scan_block_comment() {
+        // consume the star
+        bump();
+        u32 depth = 1;
+        while(currentCh && depth) {
+            // jump to the next character that could open or close a comment.
+            skip_to(simd::find_either(currentCh, end(), '/', '*'));
+            if(!currentCh)
+                break;
+            if(check('*') && nextCh && *nextCh == '/') {
+                --depth;
                 bump();
-                while(isxdigit(curr)) bump();
-                str = cursor->substr(start);
-                pos.span = str.size();
-                return EscapeCharecterType::UnicodeLong;
-            case 'u':
+            }
+            else if(check('/') && nextCh && *nextCh == '*') {
+                ++depth;
                 bump();
-                while(isxdigit(curr)) bump();
-                character = cursor->substr(start);
-                pos.span = character.size();
-                return EscapeCharecterType::UnicodeShort;
-        */
-            default:;
-       //         scan_error(scanner->file, scanner->line, scanner->column, "invalid escape character: %c\n", Current(scanner));
+            }
+            bump();
         }
-        return 0x0;
+
+        if(depth)
+            error(start, 2, "unterminated block comment");
+
+        return make_token(Tkn_Comment);
     }
 
     Scanner::State Scanner::save() {
         return State {
             index,
+            start,
             currentCh,
-            nextCh,
-            position,
-            savePos
+            nextCh
         };
     }
 
     void Scanner::restore(const State& state) {
         index = state.index;
+        start = state.start;
         currentCh = state.currentCh;
         nextCh = state.nextCh;
-        position = state.position;
-        savePos = state.savePos;
     }
 }
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "token.hpp"
+#include "token_buffer.hpp"
+#include "utils/simd.hpp"
+#include <string>
+#include <vector>
 
 namespace mist {
     class Interpreter;
@@ -9,18 +13,64 @@ namespace mist {
         public:
             struct State {
                 u64 index;               /// the index within the source
+                u64 start;               /// the index of the first character of the current token
                 const char* currentCh;         /// the current character
                 const char* nextCh;            /// the next character
-                Pos position;            /// the current position within the file
-                Pos savePos;             /// the start of current token
+            };
+
+            /// a change to the text of a file that was already tokenized.
+            struct Edit {
+                u64 offset;              /// the first character that changed
+                u64 removed;             /// the number of characters removed at offset
+                std::string_view text;   /// the text inserted at offset
+            };
+
+            /// the tokens after an edit, the old tokens [first, first + removed)
+            /// were replaced by the new tokens [first, first + inserted).
+            struct Relex {
+                TokenBuffer tokens;
+                u32 first;
+                u32 removed;
+                u32 inserted;
+            };
+
+            /// an error found while lexing a chunk, reported once the chunk is stitched.
+            struct Diagnostic {
+                u32 token;               /// index of the token being scanned in the chunk
+                u32 offset;
+                u32 length;
+                std::string message;
+            };
+
+            /// the speculative tokens of a part of a file lexed on a worker.
+            struct Chunk {
+                u64 begin;               /// the first character, always the start of a line
+                u64 end;                 /// tokens starting at or after end belong to the next chunk
+                u64 stop{0};             /// where the last token of the chunk ended
+                TokenBuffer tokens;      /// comments are kept and identifiers are not interned
+                std::vector<Diagnostic> diagnostics;
+
+                Chunk(u64 begin, u64 end) : begin(begin), end(end) {}
             };
 
             Scanner(mist::Interpreter* interp);
 
             ~Scanner();
     
-            /// tokenizes the give file.
-            // std::vector<Token> tokenize(io::File* file);
+            /// tokenizes the whole file up front. Comments are dropped. Large
+            /// files are lexed in chunks of about chunkSize characters on the
+            /// workers of the interpreter, 0 picks the size from the number of
+            /// jobs. The tokens are the same either way.
+            TokenBuffer tokenize(io::File* file, u64 chunkSize = 0);
+
+            /// lexes the tokens that start in [begin, end) of a loaded file and
+            /// ends them with Tkn_Eof. begin must be the start of a token. The
+            /// file was lexed before, so errors are not reported again.
+            TokenBuffer lex_range(io::File* file, u64 begin, u64 end);
+
+            /// applies edit to file and only re-lexes the tokens it damaged,
+            /// old must be the tokens of the file before the edit.
+            Relex relex(io::File* file, TokenBuffer old, const Edit& edit);
             
             // initializes the scanner with the new file
             void init(io::File* file);
@@ -31,6 +81,9 @@ namespace mist {
             // returns the most resent token
             Token& token();
 
+            // the line table and payloads of the tokens scanned so far.
+            TokenBuffer& tokens();
+
             State save();
 
             void restore(const State& state);
@@ -44,12 +97,42 @@ namespace mist {
         
             /// move the cursor to the next character.
             void bump();
+
+            /// move the cursor forward to p in one step, p must be within [currentCh, end].
+            void skip_to(const char* p);
+
+            /// move the cursor to any offset, the line table of buffer must cover it.
+            void seek(u64 offset);
+
+            /// reports an error at [offset, offset + length), or keeps it in
+            /// diagnostics while lexing a chunk.
+            template <typename... Args>
+            void error(u64 offset, u64 length, const char* msg, Args... args);
+
+            TokenBuffer lex_parallel(u64 chunkSize);
+
+            /// lexes the tokens of chunk, this runs on a worker thread.
+            void lex_chunk(io::File* file, Chunk& chunk);
+
+            /// appends the tokens of chunk that follow the end of the tokens
+            /// already in buffer, lexing again wherever the chunk guessed wrong.
+            void stitch(Chunk& chunk);
+
+            /// the offset of the next token, or length at the end of the source.
+            inline u64 next_start() { return currentCh ? (u64) (simd::skip_blanks(currentCh, end()) - source) : length; }
+
+            inline const char* end() { return source + length; }
     
-            // this is to allow the span to be updated as we move along.
-            inline void new_token() { position.span = 0; savePos = position; }
+            // the token being scanned starts at the cursor.
+            inline void new_token() { start = index; }
 
 			inline bool check(char ch) { return currentCh && *currentCh == ch; }
 
+            // a token from the start of the current token to the cursor.
+            inline Token make_token(TokenKind kind, u32 payload = 0) {
+                return Token(kind, (u32) start, (u32) (index - start), payload);
+            }
+
 
 		private:
 
@@ -61,22 +144,25 @@ namespace mist {
             Token scan_character();
             Token scan_string();
             Token scan_comment();
+            Token scan_block_comment();
 
             static TokenKind keyword(const std::string& str);
 
-            char validate_escape();
-
             mist::Interpreter* interp{nullptr}; /// the active interpreter
             io::File* file{nullptr}; /// the current file being scanned
             Token current;
+            TokenBuffer buffer;      /// receives the payload of every token
+            bool deferred{false};    /// lexing a chunk or a range, errors are not reported
+            bool chunked{false};     /// lexing a chunk, identifiers are interned by the stitch
+            std::vector<Diagnostic> diagnostics;
 
             // state data
             u64 index;               /// the index within the source
+            u64 start;               /// the index of the first character of the current token
             const char* currentCh;         /// the current character
             const char* nextCh;            /// the next character
-            const std::string* source;     /// the source
-            Pos position;            /// the current position within the file
-            Pos savePos;             /// the start of current token
+            const char* source;            /// the source, read directly from the file
+            u64 length;                    /// the number of characters in the source
 
 
     };
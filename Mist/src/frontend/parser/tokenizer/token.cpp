@@ -1,176 +1,88 @@
 #include "token.hpp"
-#include <vector>
-#include <algorithm>
 #include "interpreter.hpp"
 
-static const std::vector<std::string> token_strings = {
-#define TOKEN_KIND(n, str) str,
+static constexpr const char* token_strings[] = {
+#define TOKEN_KIND(n, str, ...) str,
     TOKEN_KINDS
 #undef TOKEN_KIND
 };
 
 namespace mist {
+    // Keywords are looked up through a perfect hash built at compile time
+    // from the keyword range of TOKEN_KINDS, so an identifier costs one hash
+    // and at most one string compare.
+    namespace {
+        constexpr TokenKind FirstKeyword = Tkn_Underscore;
+        constexpr TokenKind LastKeyword = Tkn_Self;
+        constexpr u32 KeywordSlots = 256;
+
+        constexpr u32 keyword_hash(std::string_view str, u32 seed) {
+            u32 hash = 2166136261u ^ seed;
+            for(auto ch : str) {
+                hash ^= (u8) ch;
+                hash *= 16777619u;
+            }
+            return hash & (KeywordSlots - 1);
+        }
 
-#define TOKEN_CONSTRUCTOR_IMP(Type, Elem, TokenType) \
-    Token::TOKEN_CONSTRUCTOR_DEF(Type) : Token(TokenType, pos) { \
-        this->Elem = elem;  \
-    }
-
-	Token::Token() {}
+        struct KeywordTable {
+            u32 seed{0};
+            u64 longest{0};
+            u8 slots[KeywordSlots]{};   // the keyword kind, 0 for an empty slot
+        };
+
+        // searches for the first seed that places every keyword in its own slot.
+        constexpr KeywordTable build_keyword_table() {
+            for(u32 seed = 0; seed < 4096; ++seed) {
+                KeywordTable table;
+                table.seed = seed;
+                bool collision = false;
+                for(u32 k = FirstKeyword; k <= LastKeyword && !collision; ++k) {
+                    std::string_view str = token_strings[k];
+                    auto& slot = table.slots[keyword_hash(str, seed)];
+                    collision = slot != 0;
+                    slot = (u8) k;
+                    table.longest = str.size() > table.longest ? str.size() : table.longest;
+                }
+                if(!collision)
+                    return table;
+            }
+            return KeywordTable();
+        }
 
-	Token::Token(TokenKind kind, const Pos& pos) : tokenKind(kind), position(pos) {}
+        constexpr KeywordTable keywords = build_keyword_table();
 
-    TOKEN_CONSTRUCTOR_IMP(u64, integer, Tkn_IntLiteral)
-    TOKEN_CONSTRUCTOR_IMP(f64, floating, Tkn_FloatLiteral)
-    TOKEN_CONSTRUCTOR_IMP(char, character, Tkn_CharLiteral)
-    TOKEN_CONSTRUCTOR_IMP(const std::string&, str, Tkn_StringLiteral)
-    TOKEN_CONSTRUCTOR_IMP(ast::Ident*, ident, Tkn_Identifier);
+        static_assert(Tkn_Error == 0 && LastKeyword < 256, "keyword slots store the kind in a byte");
+        static_assert(keywords.longest != 0, "no collision free seed for the keyword table");
+    }
 
+	Token::Token() {}
 
-    Token::~Token() {}
+	Token::Token(TokenKind kind, u32 offset, u32 length, u32 payload) : tokenKind((u16) kind),
+		offset(offset), length(length), payload(payload) {}
 
-    const std::string& Token::get_string(TokenKind kind) {
+    const char* Token::get_string(TokenKind kind) {
         return token_strings[kind];
     }
 
-    TokenKind Token::keyword(const std::string& str) {
-        auto iter = std::find(token_strings.begin(), token_strings.end(), str);
-        if(iter == token_strings.end())
+    TokenKind Token::keyword(std::string_view str) {
+        if(str.size() > keywords.longest)
             return Tkn_None;
-        else {
-            u64 index = std::distance(token_strings.begin(), iter);
-            return (TokenKind) index;
-        }
+        auto kind = keywords.slots[keyword_hash(str, keywords.seed)];
+        if(kind && str == token_strings[kind])
+            return (TokenKind) kind;
+        return Tkn_None;
     }
 
 	std::ostream& operator<< (std::ostream& out, const Token& t) {
-		out << "Token( " << token_strings[t.tokenKind] << " ";
-
-		switch (t.tokenKind) {
-            case Tkn_IntLiteral:
-                out << "(" << t.integer << ")";
-                break;
-            case Tkn_FloatLiteral:
-                out << "(" << t.floating << ")";
-                break;
-            case Tkn_StringLiteral:
-                out << "(" << t.str << ")";
-                break;
-            case Tkn_CharLiteral:
-                out << "(" << t.character << ")";
-                break;
-            case Tkn_Identifier:
-                out << "(" << t.ident->value->value() << ")";
-                break;
-            default:
-                break;
-		}
-		out << ", "
-            << t.position.line <<  ", "
-            << t.position.column << ", "
-            << t.position.span << ", "
-            << t.position.fileId << ")";
+		out << "Token( " << token_strings[t.tokenKind] << ", "
+            << t.offset << ", "
+            << t.length << ", "
+            << t.payload << ")";
 
 		return out;
 	}
 
-    i32 Token::prec() {
-        switch(kind()) {
-            case Tkn_AstrickAstrick:
-                return 12;
-            case Tkn_Slash:
-            case Tkn_Astrick:
-            case Tkn_Percent:
-                return 11;
-            case Tkn_Plus:
-            case Tkn_Minus:
-                return 10;
-            case Tkn_LessLess:
-            case Tkn_GreaterGreater:
-                return 9;
-            case Tkn_EqualEqual:
-            case Tkn_BangEqual:
-                return 8;
-            case Tkn_LessEqual:
-            case Tkn_GreaterEqual:
-            case Tkn_Less:
-            case Tkn_Greater:
-                return 7;
-            case Tkn_Ampersand:
-                return 6;
-            case Tkn_Carrot:
-                return 5;
-            case Tkn_Pipe:
-                return 4;
-            case Tkn_And:
-                return 3;
-            case Tkn_Or:
-                return 2;
-        // case Tkn_Question:
-        // case Tkn_PeriodPeriod:
-        // case Tkn_PeriodPeriodPeriod:
-        // case Tkn_InfixOp:
-        //   return 2;
-            case Tkn_Equal:
-            case Tkn_LessLessEqual:
-            case Tkn_GreaterGreaterEqual:
-            case Tkn_PlusEqual:
-            case Tkn_MinusEqual:
-            case Tkn_SlashEqual:
-            case Tkn_AstrickEqual:
-            case Tkn_AmpersandEqual:
-            case Tkn_PipeEqual:
-            case Tkn_CarrotEqual:
-            case Tkn_AstrickAstrickEqual:
-            case Tkn_PeriodPeriod:
-            case Tkn_Dollar:
-                return 1;
-            default:
-                return 0;
-        }
-    }
-
-    Associative Token::acc() {
-        switch(kind()) {
-            case Tkn_AstrickAstrick:
-            case Tkn_Dollar:
-                return Associative::Right;
-            case Tkn_Slash:
-            case Tkn_Astrick:
-            case Tkn_Percent:
-            case Tkn_Plus:
-            case Tkn_Minus:
-            case Tkn_LessLess:
-            case Tkn_GreaterGreater:
-            case Tkn_EqualEqual:
-            case Tkn_BangEqual:
-            case Tkn_LessEqual:
-            case Tkn_GreaterEqual:
-            case Tkn_Less:
-            case Tkn_Greater:
-            case Tkn_Ampersand:
-            case Tkn_Carrot:
-            case Tkn_Pipe:
-            case Tkn_And:
-            case Tkn_Or:
-            case Tkn_Equal:
-            case Tkn_LessLessEqual:
-            case Tkn_GreaterGreaterEqual:
-            case Tkn_PlusEqual:
-            case Tkn_MinusEqual:
-            case Tkn_SlashEqual:
-            case Tkn_AstrickEqual:
-            case Tkn_AmpersandEqual:
-            case Tkn_PipeEqual:
-            case Tkn_CarrotEqual:
-            case Tkn_AstrickAstrickEqual:
-            case Tkn_PeriodPeriod:
-                return Associative::Left;
-            default:
-                return Associative::None;
-        }
-    }
-
     bool Token::is_operator() {
         auto k = kind();
         return Tkn_Plus <= k && k <= Tkn_PipeEqual;
@@ -2,116 +2,117 @@
 
 #include "common.hpp"
 #include <string>
+#include <string_view>
 #include <fstream>
+#include <array>
 #include "frontend/parser/ast/ast_common.hpp"
 
+// TOKEN_KIND(name, spelling, prec, assoc), prec and assoc are the binding
+// power of a binary operator, a higher prec binds first. Tokens that are not
+// binary operators have a prec of 0.
 #define TOKEN_KINDS \
-    TOKEN_KIND(Error, "error") \
-	TOKEN_KIND(None, "none") \
-    TOKEN_KIND(Comment, "Comment") \
-    TOKEN_KIND(Eof, "EOF") \
-    TOKEN_KIND(IntLiteral, "integer literal") \
-    TOKEN_KIND(FloatLiteral, "float literal") \
-    TOKEN_KIND(StringLiteral, "string literal") \
-    TOKEN_KIND(CharLiteral, "character literal") \
-    TOKEN_KIND(Identifier, "identifier") \
-	TOKEN_KIND(NewLine, "newline") \
-    TOKEN_KIND(OpenParen, "(") \
-    TOKEN_KIND(CloseParen, ")") \
-    TOKEN_KIND(OpenBrace, "[") \
-    TOKEN_KIND(CloseBrace, "]") \
-    TOKEN_KIND(OpenBracket, "{") \
-    TOKEN_KIND(CloseBracket, "}") \
-    TOKEN_KIND(Period, ".") \
-    TOKEN_KIND(PeriodPeriod, "..") \
-    TOKEN_KIND(Comma, ",") \
-    TOKEN_KIND(Colon, ":") \
-    TOKEN_KIND(Semicolon, ";") \
-    TOKEN_KIND(ColonEqual, ":=") \
-    TOKEN_KIND(ColonColon, "::") \
-    TOKEN_KIND(MinusGreater, "->") \
-    TOKEN_KIND(Unit, "<>") \
-    TOKEN_KIND(Hash, "#") \
-    TOKEN_KIND(Dollar, "$") \
-    TOKEN_KIND(At, "@") \
-    TOKEN_KIND(Arrow, "->") \
-    TOKEN_KIND(Plus, "+") \
-    TOKEN_KIND(Minus, "-") \
-    TOKEN_KIND(Slash, "/") \
-    TOKEN_KIND(Percent, "%") \
-    TOKEN_KIND(Astrick, "*") \
-    TOKEN_KIND(AstrickAstrick, "**") \
-    TOKEN_KIND(LessLess, "<<") \
-    TOKEN_KIND(GreaterGreater, ">>") \
-    TOKEN_KIND(Ampersand, "&") \
-    TOKEN_KIND(Pipe, "|") \
-    TOKEN_KIND(Carrot, "^") \
-    TOKEN_KIND(Tilde, "~") \
-    TOKEN_KIND(Bang, "!") \
-    TOKEN_KIND(Less, "<") \
-    TOKEN_KIND(Greater, ">") \
-    TOKEN_KIND(LessEqual, "<=") \
-    TOKEN_KIND(GreaterEqual, ">=") \
-    TOKEN_KIND(EqualEqual, "==") \
-    TOKEN_KIND(BangEqual, "!=") \
-    TOKEN_KIND(Equal, "=") \
-    TOKEN_KIND(PlusEqual, "+=") \
-    TOKEN_KIND(MinusEqual, "-=") \
-    TOKEN_KIND(AstrickEqual, "*=") \
-    TOKEN_KIND(SlashEqual, "/=") \
-    TOKEN_KIND(PercentEqual, "%=") \
-    TOKEN_KIND(AstrickAstrickEqual, "**=") \
-    TOKEN_KIND(LessLessEqual, "<<=") \
-    TOKEN_KIND(GreaterGreaterEqual, ">>=") \
-    TOKEN_KIND(CarrotEqual, "^=") \
-    TOKEN_KIND(AmpersandEqual, "&=") \
-    TOKEN_KIND(PipeEqual, "|=") \
-    TOKEN_KIND(Underscore, "_") \
-    TOKEN_KIND(If, "if") \
-    TOKEN_KIND(Else, "else") \
-    TOKEN_KIND(Let, "let") \
-    TOKEN_KIND(Mut, "mut") \
-    TOKEN_KIND(Type, "type") \
-    TOKEN_KIND(Struct, "struct") \
-    TOKEN_KIND(Class, "class") \
-    TOKEN_KIND(Enum, "enum") \
-    TOKEN_KIND(Break, "break") \
-    TOKEN_KIND(Continue, "continue") \
-    TOKEN_KIND(Return, "return") \
-    TOKEN_KIND(While, "while") \
-    TOKEN_KIND(Derive, "derive") \
-    TOKEN_KIND(Where, "where") \
-    TOKEN_KIND(foriegn, "foriegn") \
-    TOKEN_KIND(Pure, "pure") \
-    TOKEN_KIND(Inline, "inline") \
-	TOKEN_KIND(Defer, "defer") \
-    TOKEN_KIND(For, "for") \
-    TOKEN_KIND(Match, "match") \
-    TOKEN_KIND(Loop, "loop") \
-    TOKEN_KIND(Sizeof, "sizeof") \
-    TOKEN_KIND(Alignof, "alignof") \
-    TOKEN_KIND(Use, "use") \
-    TOKEN_KIND(And, "and") \
-    TOKEN_KIND(Or, "or") \
-    TOKEN_KIND(In, "in") \
-    TOKEN_KIND(True, "true") \
-    TOKEN_KIND(Ref, "ref") \
-    TOKEN_KIND(False, "false") \
-    TOKEN_KIND(Null, "null") \
-    TOKEN_KIND(SelfLit, "self") \
-    TOKEN_KIND(Self, "Self")
+    TOKEN_KIND(Error, "error", 0, None) \
+	TOKEN_KIND(None, "none", 0, None) \
+    TOKEN_KIND(Comment, "Comment", 0, None) \
+    TOKEN_KIND(Eof, "EOF", 0, None) \
+    TOKEN_KIND(IntLiteral, "integer literal", 0, None) \
+    TOKEN_KIND(FloatLiteral, "float literal", 0, None) \
+    TOKEN_KIND(StringLiteral, "string literal", 0, None) \
+    TOKEN_KIND(CharLiteral, "character literal", 0, None) \
+    TOKEN_KIND(Identifier, "identifier", 0, None) \
+	TOKEN_KIND(NewLine, "newline", 0, None) \
+    TOKEN_KIND(OpenParen, "(", 0, None) \
+    TOKEN_KIND(CloseParen, ")", 0, None) \
+    TOKEN_KIND(OpenBrace, "[", 0, None) \
+    TOKEN_KIND(CloseBrace, "]", 0, None) \
+    TOKEN_KIND(OpenBracket, "{", 0, None) \
+    TOKEN_KIND(CloseBracket, "}", 0, None) \
+    TOKEN_KIND(Period, ".", 0, None) \
+    TOKEN_KIND(PeriodPeriod, "..", 1, Left) \
+    TOKEN_KIND(Comma, ",", 0, None) \
+    TOKEN_KIND(Colon, ":", 0, None) \
+    TOKEN_KIND(Semicolon, ";", 0, None) \
+    TOKEN_KIND(ColonEqual, ":=", 0, None) \
+    TOKEN_KIND(ColonColon, "::", 0, None) \
+    TOKEN_KIND(MinusGreater, "->", 0, None) \
+    TOKEN_KIND(Unit, "<>", 0, None) \
+    TOKEN_KIND(Hash, "#", 0, None) \
+    TOKEN_KIND(Dollar, "$", 1, Right) \
+    TOKEN_KIND(At, "@", 0, None) \
+    TOKEN_KIND(Arrow, "->", 0, None) \
+    TOKEN_KIND(Plus, "+", 10, Left) \
+    TOKEN_KIND(Minus, "-", 10, Left) \
+    TOKEN_KIND(Slash, "/", 11, Left) \
+    TOKEN_KIND(Percent, "%", 11, Left) \
+    TOKEN_KIND(Astrick, "*", 11, Left) \
+    TOKEN_KIND(AstrickAstrick, "**", 12, Right) \
+    TOKEN_KIND(LessLess, "<<", 9, Left) \
+    TOKEN_KIND(GreaterGreater, ">>", 9, Left) \
+    TOKEN_KIND(Ampersand, "&", 6, Left) \
+    TOKEN_KIND(Pipe, "|", 4, Left) \
+    TOKEN_KIND(Carrot, "^", 5, Left) \
+    TOKEN_KIND(Tilde, "~", 0, None) \
+    TOKEN_KIND(Bang, "!", 0, None) \
+    TOKEN_KIND(Less, "<", 7, Left) \
+    TOKEN_KIND(Greater, ">", 7, Left) \
+    TOKEN_KIND(LessEqual, "<=", 7, Left) \
+    TOKEN_KIND(GreaterEqual, ">=", 7, Left) \
+    TOKEN_KIND(EqualEqual, "==", 8, Left) \
+    TOKEN_KIND(BangEqual, "!=", 8, Left) \
+    TOKEN_KIND(Equal, "=", 1, Left) \
+    TOKEN_KIND(PlusEqual, "+=", 1, Left) \
+    TOKEN_KIND(MinusEqual, "-=", 1, Left) \
+    TOKEN_KIND(AstrickEqual, "*=", 1, Left) \
+    TOKEN_KIND(SlashEqual, "/=", 1, Left) \
+    TOKEN_KIND(PercentEqual, "%=", 1, Left) \
+    TOKEN_KIND(AstrickAstrickEqual, "**=", 1, Left) \
+    TOKEN_KIND(LessLessEqual, "<<=", 1, Left) \
+    TOKEN_KIND(GreaterGreaterEqual, ">>=", 1, Left) \
+    TOKEN_KIND(CarrotEqual, "^=", 1, Left) \
+    TOKEN_KIND(AmpersandEqual, "&=", 1, Left) \
+    TOKEN_KIND(PipeEqual, "|=", 1, Left) \
+    TOKEN_KIND(Underscore, "_", 0, None) \
+    TOKEN_KIND(If, "if", 0, None) \
+    TOKEN_KIND(Else, "else", 0, None) \
+    TOKEN_KIND(Let, "let", 0, None) \
+    TOKEN_KIND(Mut, "mut", 0, None) \
+    TOKEN_KIND(Type, "type", 0, None) \
+    TOKEN_KIND(Struct, "struct", 0, None) \
+    TOKEN_KIND(Class, "class", 0, None) \
+    TOKEN_KIND(Enum, "enum", 0, None) \
+    TOKEN_KIND(Break, "break", 0, None) \
+    TOKEN_KIND(Continue, "continue", 0, None) \
+    TOKEN_KIND(Return, "return", 0, None) \
+    TOKEN_KIND(While, "while", 0, None) \
+    TOKEN_KIND(Derive, "derive", 0, None) \
+    TOKEN_KIND(Where, "where", 0, None) \
+    TOKEN_KIND(foriegn, "foriegn", 0, None) \
+    TOKEN_KIND(Pure, "pure", 0, None) \
+    TOKEN_KIND(Inline, "inline", 0, None) \
+	TOKEN_KIND(Defer, "defer", 0, None) \
+    TOKEN_KIND(For, "for", 0, None) \
+    TOKEN_KIND(Match, "match", 0, None) \
+    TOKEN_KIND(Loop, "loop", 0, None) \
+    TOKEN_KIND(Sizeof, "sizeof", 0, None) \
+    TOKEN_KIND(Alignof, "alignof", 0, None) \
+    TOKEN_KIND(Use, "use", 0, None) \
+    TOKEN_KIND(And, "and", 3, Left) \
+    TOKEN_KIND(Or, "or", 2, Left) \
+    TOKEN_KIND(In, "in", 0, None) \
+    TOKEN_KIND(True, "true", 0, None) \
+    TOKEN_KIND(Ref, "ref", 0, None) \
+    TOKEN_KIND(False, "false", 0, None) \
+    TOKEN_KIND(Null, "null", 0, None) \
+    TOKEN_KIND(SelfLit, "self", 0, None) \
+    TOKEN_KIND(Self, "Self", 0, None)
 
 namespace mist {
 
-    struct String;
-    
     enum TokenKind {
 #define TOKEN_KIND(n, ...) Tkn_##n,
         TOKEN_KINDS
 #undef TOKEN_KIND
     };
-    
-#define TOKEN_CONSTRUCTOR_DEF(Type) Token(Type elem, const mist::Pos& pos)
 
     enum Associative {
         Right,
@@ -119,47 +120,66 @@ namespace mist {
         None
     };
 
-    struct Token {
-        Token();
+    constexpr u32 TokenKindCount = 0
+#define TOKEN_KIND(n, ...) + 1
+        TOKEN_KINDS
+#undef TOKEN_KIND
+        ;
 
-		Token(TokenKind kind, const Pos& pos);
+    /// how tightly a binary operator holds its operands, from the prec and
+    /// assoc columns of TOKEN_KINDS.
+    struct BindingPower {
+        u8 prec;
+        Associative assoc;
+    };
 
-		TOKEN_CONSTRUCTOR_DEF(u64);
-		TOKEN_CONSTRUCTOR_DEF(f64);
-		TOKEN_CONSTRUCTOR_DEF(char);
-		TOKEN_CONSTRUCTOR_DEF(const std::string&);
-		TOKEN_CONSTRUCTOR_DEF(ast::Ident*);
+    /// the binding power of every token kind, indexed by TokenKind.
+    inline constexpr std::array<BindingPower, TokenKindCount> binding_powers = {{
+#define TOKEN_KIND(n, str, prec, assoc) {prec, assoc},
+        TOKEN_KINDS
+#undef TOKEN_KIND
+    }};
 
+    /// bits of Token::flags.
+    enum TokenFlag : u16 {
+        Flag_Suffix = 0x000F,       /// suffix of a numeric literal, its ast::ConstantType + 1 or 0 if there is none
+        Flag_Escapes = 0x0010,      /// a string literal that has to be decoded
+    };
 
-        ~Token();
+    /// A token is only a view of the source. Literal values and identifiers
+    /// are stored in the side tables of the TokenBuffer that produced it and
+    /// the payload is the index into them.
+    struct Token {
+        Token();
+
+		Token(TokenKind kind, u32 offset, u32 length, u32 payload = 0);
+
+        inline const char* get_string() { return Token::get_string(kind()); }
 
-        inline const std::string& get_string() { return Token::get_string(tokenKind); }
+        static const char* get_string(TokenKind kind);
 
-        static const std::string& get_string(TokenKind kind);
-        static TokenKind keyword(const std::string& str);
+        /// returns the keyword spelled by str or Tkn_None if str is not a keyword.
+        static TokenKind keyword(std::string_view str);
 		
-		inline TokenKind kind() { return tokenKind; }
-		inline const Pos& pos() { return position; }
+		inline TokenKind kind() const { return (TokenKind) tokenKind; }
+
+        inline u32 suffix() const { return flags & Flag_Suffix; }
 
         bool is_operator();
 
         bool is_assignment();
 
-        i32 prec();
-        Associative acc();
+        inline i32 prec() const { return binding_powers[tokenKind].prec; }
+        inline Associative acc() const { return binding_powers[tokenKind].assoc; }
 
-        TokenKind tokenKind;
-		Pos position;
+        u16 tokenKind{Tkn_Error};
+        u16 flags{0};
+        u32 offset{0};      /// offset of the first character in the file
+        u32 length{0};      /// number of characters in the token
+        u32 payload{0};     /// index into the side table of the kind
 
 		friend std::ostream& operator<< (std::ostream& out, const Token& t);
-    
-        std::string str;
-//		enum {
-			u64 integer;
-            f64 floating;
-            char character;
-			ast::Ident* ident;
- //       };
     };
-}
 
+    static_assert(sizeof(Token) == 16, "tokens are copied by value, keep them small");
+}
@@ -0,0 +1,48 @@
+#include "token_buffer.hpp"
+
+namespace mist {
+    TokenBuffer::TokenBuffer() = default;
+
+    TokenBuffer::TokenBuffer(u32 base) : base(base) {}
+
+    Pos TokenBuffer::pos(u32 index) const {
+        return pos(starts[index], spans[index]);
+    }
+
+    Pos TokenBuffer::pos(const Token& token) const {
+        return pos(token.offset, token.length);
+    }
+
+    Pos TokenBuffer::pos(u32 offset, u32 length) const {
+        return Pos(base + offset, length);
+    }
+
+    void TokenBuffer::push(const Token& token) {
+        kinds.push_back((u8) token.tokenKind);
+        flags.push_back(token.flags);
+        starts.push_back(token.offset);
+        spans.push_back(token.length);
+        payloads.push_back(token.payload);
+    }
+
+    u32 TokenBuffer::add_integer(u64 value) {
+        integers.push_back(value);
+        return (u32) integers.size() - 1;
+    }
+
+    u32 TokenBuffer::add_float(f64 value) {
+        floats.push_back(value);
+        return (u32) floats.size() - 1;
+    }
+
+    void TokenBuffer::append(const TokenBuffer& other, u32 first, u32 last, i64 shift) {
+        kinds.insert(kinds.end(), other.kinds.begin() + first, other.kinds.begin() + last);
+        flags.insert(flags.end(), other.flags.begin() + first, other.flags.begin() + last);
+        spans.insert(spans.end(), other.spans.begin() + first, other.spans.begin() + last);
+        payloads.insert(payloads.end(), other.payloads.begin() + first, other.payloads.begin() + last);
+        u64 at = starts.size();
+        starts.resize(at + (last - first));
+        for(u32 i = first; i < last; ++i)
+            starts[at++] = (u32) (other.starts[i] + shift);
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "token.hpp"
+#include <vector>
+
+namespace mist {
+
+    /// A whole file lexed up front. Tokens are stored as a struct of arrays
+    /// so the parser walks them by index: the kind, the offset of the first
+    /// character and the span of each token live in parallel arrays and the
+    /// payload of literals and identifiers is an index into a side table.
+    struct TokenBuffer {
+        TokenBuffer();
+        TokenBuffer(u32 base);
+
+        /// the number of tokens, the last token is always Tkn_Eof.
+        inline u32 size() const { return (u32) kinds.size(); }
+
+        inline TokenKind kind(u32 index) const { return (TokenKind) kinds[index]; }
+
+        /// the first index from index on that does not hold a token of kind,
+        /// it stops at the Tkn_Eof.
+        inline u32 skip(u32 index, TokenKind kind) const {
+            u32 last = size() - 1;
+            while(index < last && kinds[index] == kind)
+                ++index;
+            return index;
+        }
+
+        /// the position of the token, offsets in the buffer are from the start of the file.
+        Pos pos(u32 index) const;
+        Pos pos(const Token& token) const;
+        Pos pos(u32 offset, u32 length) const;
+
+        /// builds the token at index.
+        inline Token get(u32 index) const {
+            Token token(kind(index), starts[index], spans[index], payloads[index]);
+            token.flags = flags[index];
+            return token;
+        }
+
+        /// appends a token, its payload must already be in the side tables.
+        void push(const Token& token);
+
+        // reading the payload of a token.
+        inline u64 integer(const Token& token) const { return integers[token.payload]; }
+        inline f64 floating(const Token& token) const { return floats[token.payload]; }
+        inline char character(const Token& token) const { return (char) token.payload; }
+        inline u32 symbol(const Token& token) const { return token.payload; }
+
+        // adding a payload, returns the index that goes in the token.
+        u32 add_integer(u64 value);
+        u32 add_float(f64 value);
+
+        /// appends the tokens [first, last) of other, moving them by shift.
+        /// Their payloads must index the same side tables as this buffer.
+        void append(const TokenBuffer& other, u32 first, u32 last, i64 shift = 0);
+
+        std::vector<u8> kinds;
+        std::vector<u16> flags;
+        std::vector<u32> starts;
+        std::vector<u32> spans;
+        std::vector<u32> payloads;     /// index into the side table of the kind
+
+        // side tables, characters and symbol ids are stored in the payload itself
+        // and strings are read from the source when they are needed.
+        std::vector<u64> integers;
+        std::vector<f64> floats;
+
+        u32 base{0};                   /// offset of the file in the io::SourceManager
+    };
+}
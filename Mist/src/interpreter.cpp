@@ -2,28 +2,107 @@
 
 #include "frontend/parser/tokenizer/scanner.hpp"
 #include "frontend/parser/parser.hpp"
-#include "frontend/parser/ast/ast_printer.hpp"
+#include "frontend/parser/parse_cache.hpp"
+#include "frontend/parser/ast/ast_emitter.hpp"
+#include "frontend/parser/ast/ast_check.hpp"
+#include "frontend/parser/ast/ast_flat.hpp"
+#include "frontend/parser/ast/ast_decl.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <unordered_set>
 
 #ifdef _WIN32
     #include <windows.h>
 #endif
 
-const u32 BUFFER_SIZE = 128; // if it larger then 128 for now then there is problem
+const u32 BUFFER_SIZE = 4096; // realpath writes up to PATH_MAX characters
 
 namespace mist {
-    // @TODO: parser the command line arguments
+    // OFFSET,REMOVED,TEXT of --edit, false when it is malformed.
+    static bool parse_edit(const std::string& value, std::vector<RootEdit>& edits) {
+        char* end = nullptr;
+        u64 offset = std::strtoull(value.c_str(), &end, 10);
+        if(*end != ',')
+            return false;
+        u64 removed = std::strtoull(end + 1, &end, 10);
+        if(*end != ',')
+            return false;
+
+        std::string text;
+        for(const char* c = end + 1; *c; ++c) {
+            if(*c != '\\' || !c[1]) {
+                text.push_back(*c);
+                continue;
+            }
+            switch(*++c) {
+                case 'n': text.push_back('\n'); break;
+                case 't': text.push_back('\t'); break;
+                default: text.push_back(*c); break;
+            }
+        }
+        edits.emplace_back(offset, removed, std::move(text));
+        return true;
+    }
+
     Context::Context(const std::vector<std::string>& args) : args(args) {
+        for(u64 i = 0; i < args.size(); ++i) {
+            auto& arg = args[i];
+            if(arg == "-j" || arg == "--jobs") {
+                if(i + 1 < args.size())
+                    opts.jobs = (u32) std::strtoul(args[++i].c_str(), nullptr, 10);
+            }
+            else if(arg.compare(0, 2, "-j") == 0)
+                opts.jobs = (u32) std::strtoul(arg.c_str() + 2, nullptr, 10);
+            else if(arg.compare(0, 7, "--jobs=") == 0)
+                opts.jobs = (u32) std::strtoul(arg.c_str() + 7, nullptr, 10);
+            else if(arg == "--trace")
+                opts.trace = trace::Verbose;
+            else if(arg.compare(0, 8, "--trace=") == 0)
+                opts.trace = (u32) std::strtoul(arg.c_str() + 8, nullptr, 10);
+            else if(arg == "--emit")
+                opts.emit = ast::Emit_Text;
+            else if(arg.compare(0, 7, "--emit=") == 0) {
+                opts.emit = ast::emit_format(std::string_view(arg).substr(7));
+                if(opts.emit == ast::Emit_None)
+                    std::cerr << "unknown format in '" << arg << "', expecting text, json or sexpr" << std::endl;
+            }
+            else if(arg.compare(0, 8, "--cache=") == 0)
+                opts.cache = arg.substr(8);
+            else if(arg == "--check")
+                opts.check = true;
+            else if(arg.compare(0, 7, "--edit=") == 0) {
+                if(!parse_edit(arg.substr(7), opts.edits))
+                    std::cerr << "malformed '" << arg << "', expecting --edit=OFFSET,REMOVED,TEXT" << std::endl;
+            }
+            else
+                opts.files.push_back(arg);
+        }
+
+        if(opts.jobs == 0)
+            opts.jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    const Options& Context::options() {
+        return opts;
+    }
+
+    io::SourceManager& Context::sources() {
+        return sourceManager;
     }
-    
     
     io::File* Context::root() {
         // for now it is assumed the file is the first argument     
-        auto& filename = args.front();
+        auto& filename = opts.files.front();
 
 		return load_file(filename);
     }
 
-    io::File* Context::load_file(const std::string& filename) {
+    io::File* Context::load_file(const std::string& filename, bool* created) {
         char tmpBuffer[BUFFER_SIZE];
 		char** ttBuffer = nullptr;
         int res = 0;
@@ -49,13 +128,17 @@ namespace mist {
         auto name = std::string(tmpBuffer);
         
         u64 hash = io::File::hash_filename(name);
+        std::lock_guard<std::mutex> lock(fileMutex);
         auto iter = files.find(hash);
+        if(created)
+            *created = iter == files.end();
         if(iter == files.end())
             return create_file(name);
         return iter->second;
     }
 
     io::File* Context::get_file(u64 id) {
+        std::lock_guard<std::mutex> lock(fileMutex);
         auto iter = files.find(id);
         if(iter == files.end())
             return nullptr;
@@ -69,37 +152,241 @@ namespace mist {
         return file;
     }
 
-	String* Context::find_or_create_string(const std::string& str) {
-		auto iter = stringTable.find(str);
-		if (iter != stringTable.end())
+	Interner& Context::interner() {
+		return names;
+	}
+
+	String* Context::find_or_create_literal(std::string_view str) {
+		std::lock_guard<std::mutex> lock(literalMutex);
+		auto iter = literalTable.find(str);
+		if (iter != literalTable.end())
 			return iter->second;
 
-		/// creating this struct with an allocator
+		// Strings are never freed, so a view of val stays valid as the key.
 		mist::String* s = new mist::String;
-		s->val = str;
-		stringTable.emplace(str, s);
+		s->val = std::string(str);
+		literalTable.emplace(s->val, s);
 		return s;
 	}
 
     Interpreter::Interpreter(const std::vector<std::string>& args) : context(args) {
+        trace::set_level((trace::Level) std::min<u32>(context.options().trace, trace::Verbose));
+        if(!context.options().cache.empty())
+            cache = new ParseCache(context.options().cache);
     }
 
     Interpreter::~Interpreter() {
+        delete pool;
+        delete cache;
     }
 
     void Interpreter::compile_root() {
         auto root = context.root();
 
+        auto m = load_modules(root);
+
+        if(m && !context.options().edits.empty()) {
+            for(auto x : modules)
+                if(x->file == root)
+                    m = x->module = edit_root(x);
+        }
+
+        if(context.options().check) {
+            for(auto x : modules)
+                if(x->module)
+                    ast::check(x->module, this, std::cerr);
+        }
+
+        auto format = context.options().emit;
+        if(m && format != ast::Emit_None) {
+            ast::Emitter emitter(std::cout, format, context.interner());
+            emitter.emit(m);
+        }
+
+        if(trace::level() != trace::Off)
+            dump_trace(std::cerr);
+    }
+
+    ast::Module* Interpreter::load_modules(io::File* root) {
+        // the pool has to exist before jobs start asking for it.
+        auto& pool = workers();
+        pool.submit([this, root]() { load_module(root, false); });
+        pool.wait();
+
+        LoadedModule* unit = nullptr;
+        for(auto x : modules)
+            if(x->file == root)
+                unit = x;
+
+        if(modules.size() > 1)
+            report_critical_path(unit);
+        // stdout may hold the emitted ast.
+        if(cache)
+            cache->report(std::cerr);
+        return unit->module;
+    }
+
+    void Interpreter::load_module(io::File* file, bool lazy) {
+        auto unit = new LoadedModule(file);
+
+        auto start = std::chrono::steady_clock::now();
+        if(cache && sources().load(file) == io::Source_Ok)
+            unit->module = cache->find(file, lazy, this);
+
+        if(!unit->module) {
+            u32 errors = error_count();
+            auto p = get_parser();
+            p->lazyBodies = lazy;
+            unit->module = p->parse_module(file);
+            close_parser(p);
+
+            // a module with errors is parsed again next time, so they are reported again.
+            if(cache && error_count() == errors)
+                cache->store(file, lazy, unit->module, this);
+        }
+        unit->time = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // only the job that created the file of an import parses it.
+        for(auto decl : unit->module->toplevelDeclarations) {
+            if(!decl || decl->kind() != ast::Use)
+                continue;
+            bool created = false;
+            auto imported = find_import(file, static_cast<ast::UseDecl*>(decl), created);
+            if(!imported)
+                continue;
+            unit->imports.push_back(imported);
+            if(created)
+                workers().submit([this, imported]() { load_module(imported, true); });
+        }
+
+        std::lock_guard<std::mutex> lock(moduleMutex);
+        modules.push_back(unit);
+    }
+
+    io::File* Interpreter::find_import(io::File* from, ast::UseDecl* use, bool& created) {
+        // use a.b.c names the file a/b/c.mst next to the importing file, or
+        // a/b.mst when c is an item of it. The longest path that exists wins.
+        auto& names = use->path->names;
+        std::string path;
+        for(u32 count = names.size(); count > 0; --count) {
+            path = from->dir();
+            for(u32 i = 0; i < count; ++i) {
+                if(i) path += '/';
+                path += symbol(names[i]->value);
+            }
+            path += ".mst";
+            if(auto file = context.load_file(path, &created))
+                return file;
+        }
+
+        std::string name;
+        for(auto x : names)
+            name += (name.empty() ? "" : ".") + std::string(symbol(x->value));
+        report_error(use->path->pos, "unable to find module '%s'", name.c_str());
+        return nullptr;
+    }
+
+    ast::Module* Interpreter::edit_root(LoadedModule* root) {
+        auto file = root->file;
+        bool check = context.options().check;
+
         auto p = get_parser();
+        p->lazyBodies = false;
+        ParseState state;
+        auto module = p->parse_module(file, state);
 
-        auto m = p->parse_root(root);
+        for(auto& edit : context.options().edits) {
+            u32 base = sources().base(file);
+            auto start = std::chrono::steady_clock::now();
+            module = p->reparse_module(module, state, Scanner::Edit{edit.offset, edit.removed, edit.text});
+            std::chrono::duration<f64, std::milli> reparse = std::chrono::steady_clock::now() - start;
+            if(!check)
+                continue;
 
-        ast::print(std::cout, m);
+            // the errors of the fresh parse were reported by the reparse already.
+            std::vector<std::string> ignored;
+            capture_errors(&ignored);
+            start = std::chrono::steady_clock::now();
+            auto fresh = p->parse_module(file);
+            std::chrono::duration<f64, std::milli> parse = std::chrono::steady_clock::now() - start;
+            capture_errors(nullptr);
+
+            // the flat trees hold every node and position of both.
+            bool same = ast::flatten(module) == ast::flatten(fresh);
+            delete fresh;
+
+            // written to stderr, stdout may hold the emitted ast.
+            std::cerr << file->name() << ": edit at " << edit.offset << " reparsed in " << reparse.count()
+                << "ms, parsed in " << parse.count() << "ms";
+            if(sources().base(file) != base)
+                std::cerr << ", the file moved from " << base << " to " << sources().base(file);
+            std::cerr << std::endl;
+            if(!same)
+                std::cerr << file->name() << ": the reparse differs from a fresh parse" << std::endl;
+        }
 
         close_parser(p);
+        return module;
+    }
+
+    // Imports are only known once the importing module is parsed, so the
+    // modules along a chain of imports are parsed one after another however
+    // many workers there are. The heaviest chain bounds the loading time.
+    void Interpreter::report_critical_path(LoadedModule* root) {
+        std::unordered_map<io::File*, LoadedModule*> units;
+        f64 total = 0;
+        for(auto x : modules) {
+            units[x->file] = x;
+            total += x->time;
+        }
+
+        // the cost of the heaviest chain starting at a module and the next
+        // module on it. Imports back into a module being visited are cycles
+        // and are left out, a chain only goes on to modules that are done.
+        struct Chain {
+            f64 cost{0};
+            LoadedModule* next{nullptr};
+            bool visiting{false};
+            bool done{false};
+        };
+        std::unordered_map<LoadedModule*, Chain> chains;
+        std::function<f64(LoadedModule*)> visit = [&](LoadedModule* unit) -> f64 {
+            auto& chain = chains[unit];
+            if(chain.done || chain.visiting)
+                return chain.done ? chain.cost : 0;
+            chain.visiting = true;
+            f64 best = 0;
+            LoadedModule* next = nullptr;
+            for(auto file : unit->imports) {
+                auto iter = units.find(file);
+                if(iter == units.end())
+                    continue;
+                f64 cost = visit(iter->second);
+                if(!chains[iter->second].done)
+                    continue;
+                if(cost > best || !next) {
+                    best = cost;
+                    next = iter->second;
+                }
+            }
+            auto& result = chains[unit];
+            result.cost = unit->time + best;
+            result.next = next;
+            result.visiting = false;
+            result.done = true;
+            return result.cost;
+        };
+
+        // written to stderr, stdout may hold the emitted ast.
+        f64 cost = visit(root);
+        std::cerr << "Critical path: " << cost << "ms of " << total << "ms parsing " << modules.size() << " modules" << std::endl;
+        std::unordered_set<LoadedModule*> printed;
+        for(auto unit = root; unit && printed.insert(unit).second; unit = chains[unit].next)
+            std::cerr << "    " << unit->file->name() << " " << unit->time << "ms" << std::endl;
     }
 
     Parser* Interpreter::get_parser() {
+        std::lock_guard<std::mutex> lock(parserMutex);
         for(auto& x : parsers) {
             if(!x.second) {
                 x.second = true;
@@ -111,15 +398,85 @@ namespace mist {
         return p; 
     }
 
+    io::SourceManager& Interpreter::sources() {
+        return context.sources();
+    }
+
+    u32 Interpreter::jobs() {
+        return context.options().jobs;
+    }
+
+    ThreadPool& Interpreter::workers() {
+        if(!pool)
+            pool = new ThreadPool(jobs() - 1);
+        return *pool;
+    }
+
+    void Interpreter::dump_trace(std::ostream& out) {
+#if MIST_TRACE_LEVEL == 0
+        out << "tracing is compiled out, build with MIST_TRACE_LEVEL above 0" << std::endl;
+#endif
+        auto records = trace::collect();
+        u64 start = records.empty() ? 0 : records.front().event.time;
+        for(auto& record : records) {
+            auto& event = record.event;
+            out << "[" << record.thread << "] +" << (event.time - start) / 1000.0 << "us\t" << event.name;
+            if(event.detail)
+                out << " " << event.detail;
+            auto location = context.sources().resolve(event.offset);
+            if(event.offset && location.file)
+                out << " " << location.file->name() << ":" << location.line << ":" << location.column;
+            out << " " << event.value << "\n";
+        }
+        out.flush();
+    }
+
     void Interpreter::close_parser(Parser* p) {
+        std::lock_guard<std::mutex> lock(parserMutex);
         for(auto& x : parsers)
             if(x.first == p)
                 x.second = false;
     }
 
 
-    String* Interpreter::find_string(const std::string& str) {
-        return context.find_or_create_string(str);
+    u32 Interpreter::intern(std::string_view str) {
+        return context.interner().intern(str);
+    }
+
+    std::string_view Interpreter::symbol(u32 id) {
+        return context.interner().get(id);
+    }
+
+    Interner& Interpreter::interner() {
+        return context.interner();
+    }
+
+    String* Interpreter::find_literal(std::string_view str) {
+        return context.find_or_create_literal(str);
+    }
+
+    void Interpreter::capture_errors(std::vector<std::string>* diagnostics) {
+        captured() = diagnostics;
+    }
+
+    void Interpreter::print_errors(const std::vector<std::string>& diagnostics) {
+        reported() += (u32) diagnostics.size();
+        for(auto& line : diagnostics)
+            std::cerr << line << std::endl;
+    }
+
+    u32 Interpreter::error_count() {
+        return reported();
+    }
+
+    std::vector<std::string>*& Interpreter::captured() {
+        static thread_local std::vector<std::string>* diagnostics = nullptr;
+        return diagnostics;
+    }
+
+    u32& Interpreter::reported() {
+        static thread_local u32 count = 0;
+        return count;
     }
 
 // //#pragma optimize("", off)
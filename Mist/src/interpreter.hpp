@@ -2,15 +2,29 @@
 
 #include "common.hpp"
 #include "utils/file.hpp"
+#include "utils/source_manager.hpp"
+#include "utils/interner.hpp"
 #include "frontend/parser/ast/ast_common.hpp"
 
 #include <unordered_map>
+#include <string_view>
 #include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 #include <iostream>
 
+namespace ast {
+    struct UseDecl;
+    enum EmitFormat : u8;
+}
+
 namespace mist {
     class Parser;
+    class ParseCache;
+    class ThreadPool;
 
     struct String {
         std::string val; 
@@ -18,35 +32,78 @@ namespace mist {
         inline const std::string& value() { return val; }
     };
 
+    /// a parsed file of the program and the files its use declarations name.
+    struct LoadedModule {
+        io::File* file;
+        ast::Module* module{nullptr};
+        std::vector<io::File*> imports;
+        f64 time{0};                        /// milliseconds spent lexing and parsing the file
+
+        LoadedModule(io::File* file) : file(file) {}
+    };
+
+    /// a change to the root given on the command line.
+    struct RootEdit {
+        u64 offset;                         /// the first character replaced
+        u64 removed;                        /// the number of characters replaced
+        std::string text;                   /// what replaces them
+
+        RootEdit(u64 offset, u64 removed, std::string text) : offset(offset), removed(removed), text(std::move(text)) {}
+    };
+
+    /// settings taken from the command line.
+    struct Options {
+        std::vector<std::string> files;     /// every argument that isn't an option
+        u32 jobs{1};                        /// worker threads, -j N or --jobs=N, 0 is one per core
+        u32 trace{0};                       /// the trace level, --trace=N, the events are dumped to stderr after the run
+        ast::EmitFormat emit{};             /// --emit=text, json or sexpr writes the ast of the root to stdout, nothing is written without it
+        std::string cache;                  /// --cache=DIR keeps parsed modules in DIR and reuses them while their files are unchanged
+        bool check{false};                  /// --check walks every module with ast::check, the differences are written to stderr
+        std::vector<RootEdit> edits;        /// --edit=OFFSET,REMOVED,TEXT edits the root once it is parsed and parses it again, in the order given. \n and \t in TEXT are escapes
+    };
+
 	class Context {
 		public:
             Context(const std::vector<std::string>& args);
+
+            const Options& options();
+
+            /// the address space of every loaded file.
+            io::SourceManager& sources();
             
     
             /// Returns the root file (the file given as a parameter).
             io::File* root();
     
-            /// looks if the file is create if it isnt then creates it
-            io::File* load_file(const std::string& filename);
+            /// looks if the file is create if it isnt then creates it. created
+            /// is set when this call made the file, files are only made once.
+            io::File* load_file(const std::string& filename, bool* created = nullptr);
     
         
             /// gets a loaded file by id
             io::File* get_file(u64 id);
     
-            /// looks for an existing string
-            /// if it doesnt find one it creates it and returns it.
-            /// if it does then it just returns that one.
-            String* find_or_create_string(const std::string& str);
+            /// the names of every identifier.
+            Interner& interner();
+
+            /// the pooled copy of a decoded string literal, identical
+            /// literals share the same String.
+            String* find_or_create_literal(std::string_view str);
             
 		private:
             /// creates a file of the given filename
             io::File* create_file(const std::string& filename);
 
     
-            std::unordered_map<std::string, String*> stringTable;
-            std::unordered_map<u64, io::File*> files;
+            Interner names;
+            std::unordered_map<std::string_view, String*> literalTable;    // keys view the val of the String
+            std::mutex literalMutex;                                        // modules may be parsed on several threads
+            std::unordered_map<u64, io::File*> files;                      // keyed by the hash of the absolute path
+            std::mutex fileMutex;                                           // imports are loaded from several threads
             // Settings
             std::vector<std::string> args;
+            Options opts;
+            io::SourceManager sourceManager;
 	};
 
 	class Interpreter {
@@ -56,25 +113,95 @@ namespace mist {
 
             void compile_root();
 
-            String* find_string(const std::string& str);
+            /// parses root and every module it imports, directly or not. Each
+            /// module is parsed as a job on the workers once the module that
+            /// imports it has been parsed. Returns the module of root.
+            ast::Module* load_modules(io::File* root);
+
+            /// the symbol id of an identifier.
+            u32 intern(std::string_view str);
+
+            /// the text of a symbol id.
+            std::string_view symbol(u32 id);
+
+            Interner& interner();
+
+            String* find_literal(std::string_view str);
 
             Parser* get_parser();
             void close_parser(Parser* p);
 
+            io::SourceManager& sources();
+
+            /// the number of threads work may be split over, including the calling thread.
+            u32 jobs();
+
+            /// the shared workers, created on first use.
+            ThreadPool& workers();
+
+            /// writes the trace events of every thread, oldest first.
+            void dump_trace(std::ostream& out);
+
             template <typename... Args>
             void report_error(const Pos& pos, const std::string& msg, Args... args) {
-        		auto file = context.get_file(pos.fileId);
-        		std::cout << file->name() << ":" << pos.line << ":" << pos.column << "\t";
-#if _WIN32
-        		printf_s(msg.c_str(), args...);
-#else
-                printf(msg.c_str(), args...);
-#endif
-        		std::cout << std::endl;
+                // line and column are only worked out for positions that are printed.
+                std::string line;
+                auto location = context.sources().resolve(pos.offset);
+                if(location.file)
+                    line = location.file->name() + ":" + std::to_string(location.line) + ":" + std::to_string(location.column) + "\t";
+
+                int size = std::snprintf(nullptr, 0, msg.c_str(), args...);
+                if(size > 0) {
+                    auto length = line.size();
+                    line.resize(length + (size_t) size);
+                    std::snprintf(&line[length], (size_t) size + 1, msg.c_str(), args...);
+                }
+
+                ++reported();
+                if(auto diagnostics = captured())
+                    diagnostics->push_back(std::move(line));
+                else    // stderr, stdout only holds the emitted ast.
+                    std::cerr << line << std::endl;
             }
+
+            /// while a thread has diagnostics set, its errors are added to them
+            /// instead of being printed. nullptr goes back to printing.
+            static void capture_errors(std::vector<std::string>* diagnostics);
+
+            /// prints errors kept by capture_errors.
+            void print_errors(const std::vector<std::string>& diagnostics);
+
+            /// the errors the calling thread has reported or printed, it only
+            /// grows. Work that compares it before and after had errors.
+            static u32 error_count();
 		private:
+            static std::vector<std::string>*& captured();
+            static u32& reported();
+
+            // parses file and queues the imports nobody has loaded yet. Imports
+            // are parsed with lazy bodies, most of them are only needed for
+            // their signatures.
+            void load_module(io::File* file, bool lazy);
+
+            // the file a use declaration in from names, nullptr if there is none.
+            io::File* find_import(io::File* from, ast::UseDecl* use, bool& created);
+
+            // parses the root again and applies the edits of the options to it
+            // one by one, each followed by Parser::reparse_module. With --check
+            // each result is compared with a fresh parse of the edited file.
+            // Returns the module of the last edit.
+            ast::Module* edit_root(LoadedModule* root);
+
+            // prints the longest chain of imports weighted by parse time to stderr.
+            void report_critical_path(LoadedModule* root);
+
 			Context context;
+            ThreadPool* pool{nullptr};
+            ParseCache* cache{nullptr};                 // only with --cache
             std::vector<std::pair<Parser*, bool>> parsers;
+            std::mutex parserMutex;
+            std::vector<LoadedModule*> modules;         // in the order they were parsed
+            std::mutex moduleMutex;
             // std::vector<Parser*> parsers;
 	};
 }
@@ -5,7 +5,6 @@
 
 #include "interpreter.hpp"
 #include "frontend/parser/ast/ast.hpp"
-#include "frontend/parser/ast/ast_printer.hpp"
 #include "frontend/parser/ast/ast_common.hpp"
 #include "frontend/parser/ast/ast_decl.hpp"
 #include "frontend/parser/ast/ast_expr.hpp"
@@ -28,5 +27,5 @@ int main(int argc, const char** argv) {
 	auto end = std::chrono::high_resolution_clock::now();
 
 	auto diff = end - start;
-	std::cout << "Time: " << static_cast<std::chrono::duration<double>>(diff).count() << std::endl;
+	std::cerr << "Time: " << static_cast<std::chrono::duration<double>>(diff).count() << std::endl;
 }
@@ -0,0 +1,40 @@
+#include "arena.hpp"
+
+#include <cstdint>
+
+namespace mist {
+    namespace {
+        const u64 BlockSize = 64 * 1024;
+    }
+
+    Arena::Arena() = default;
+
+    Arena::~Arena() {
+        for(auto block : blocks)
+            delete[] block;
+    }
+
+    void* Arena::alloc(u64 size, u64 align) {
+        auto p = (char*) (((uintptr_t) cursor + align - 1) & ~(uintptr_t) (align - 1));
+        if(!cursor || p + size > limit) {
+            // anything too large for a block gets one of its own.
+            u64 length = size + align > BlockSize ? size + align : BlockSize;
+            cursor = new char[length];
+            limit = cursor + length;
+            total += length;
+            blocks.push_back(cursor);
+            p = (char*) (((uintptr_t) cursor + align - 1) & ~(uintptr_t) (align - 1));
+        }
+        cursor = p + size;
+        return p;
+    }
+
+    void Arena::adopt(Arena& other) {
+        blocks.insert(blocks.end(), other.blocks.begin(), other.blocks.end());
+        total += other.total;
+        other.blocks.clear();
+        other.cursor = nullptr;
+        other.limit = nullptr;
+        other.total = 0;
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "common.hpp"
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mist {
+
+    /// A run of elements that lives in an Arena, it does not own them.
+    template <typename T>
+    struct Span {
+        T* data{nullptr};
+        u32 count{0};
+
+        Span() = default;
+        Span(T* data, u32 count) : data(data), count(count) {}
+
+        inline T* begin() const { return data; }
+        inline T* end() const { return data + count; }
+        inline u32 size() const { return count; }
+        inline bool empty() const { return count == 0; }
+        inline T& operator[] (u32 index) const { return data[index]; }
+        inline T& front() const { return data[0]; }
+        inline T& back() const { return data[count - 1]; }
+    };
+
+    /// A bump allocator. Objects are placed one after another in large blocks
+    /// and are never destroyed on their own, all of the memory is released at
+    /// once with the arena.
+    class Arena {
+        public:
+            Arena();
+            ~Arena();
+
+            Arena(const Arena&) = delete;
+            Arena& operator= (const Arena&) = delete;
+
+            void* alloc(u64 size, u64 align);
+
+            /// constructs a T in the arena, its destructor is never run.
+            template <typename T, typename... Args>
+            T* make(Args&&... args) {
+                static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+                return new (alloc(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            }
+
+            /// copies the elements into the arena.
+            template <typename T>
+            Span<T> copy(const std::vector<T>& elements) {
+                static_assert(std::is_trivially_copyable<T>::value, "spans are copied by bytes");
+                if(elements.empty())
+                    return Span<T>();
+                auto data = (T*) alloc(sizeof(T) * elements.size(), alignof(T));
+                std::copy(elements.begin(), elements.end(), data);
+                return Span<T>(data, (u32) elements.size());
+            }
+
+            /// takes over the blocks of other, which is left empty. Objects made
+            /// in other stay where they are and live as long as this arena.
+            void adopt(Arena& other);
+
+            /// the number of bytes taken from the system.
+            inline u64 reserved() const { return total; }
+
+        private:
+            std::vector<char*> blocks;
+            char* cursor{nullptr};
+            char* limit{nullptr};
+            u64 total{0};
+    };
+}
@@ -1,13 +1,19 @@
 #include "file.hpp"
+#include "hash.hpp"
 #include <cstdio>
 #include <iostream>
 
-#include <sstream>
-#include <fstream>
-
-
 #include <functional>
 
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 namespace io {
     
     std::string find_end_relative(const std::string& path, char delim) {
@@ -25,24 +31,156 @@ namespace io {
         this->path = path.substr(0, index + 1);
     }
 
+    File::~File() {
+        unload();
+    }
+
     bool File::load(bool force) {
 		if (loaded && !force) return true;
 
-        std::fstream ff(fullpath());
-        if(!ff) return false;
+        unload();
 
-        std::stringstream ss;
-        ss << ff.rdbuf();
-        content = ss.str();
-        
+        // mapping fails for empty files and anything that isn't a regular file.
+        if(!map() && !read())
+            return false;
+
+        contentHash = mist::hash64(content, length);
         loaded = true;
         return true;
     }
 
+    void File::unload() {
+        unmap();
+        buffer.clear();
+        buffer.shrink_to_fit();
+        content = nullptr;
+        length = 0;
+        contentHash = 0;
+        loaded = false;
+    }
+
+    bool File::edit(u64 offset, u64 removed, std::string_view text) {
+        if(!loaded || offset > length || removed > length - offset)
+            return false;
+
+        // an edited file no longer matches the disk, so it keeps its own copy.
+        if(mapped) {
+            std::string copy(content, length);
+            unmap();
+            buffer = std::move(copy);
+        }
+
+        buffer.replace(offset, removed, text.data(), text.size());
+        content = buffer.data();
+        length = buffer.size();
+        contentHash = mist::hash64(content, length);
+        return true;
+    }
+
+    void File::unmap() {
+        if(!mapped)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(content);
+        CloseHandle((HANDLE) mapping);
+        mapping = nullptr;
+#else
+        munmap((void*) content, length);
+#endif
+        mapped = false;
+    }
+
+    bool File::map() {
+#ifdef _WIN32
+        HANDLE handle = CreateFileA(fullpath().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if(handle == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if(GetFileType(handle) != FILE_TYPE_DISK || !GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle(handle);
+            return false;
+        }
+
+        HANDLE m = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        // the mapping keeps the file open.
+        CloseHandle(handle);
+        if(!m)
+            return false;
+
+        void* view = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+        if(!view) {
+            CloseHandle(m);
+            return false;
+        }
+
+        mapping = m;
+        content = (const char*) view;
+        length = (u64) fileSize.QuadPart;
+#else
+        int fd = open(fullpath().c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+
+        struct stat st;
+        if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+            close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps its own reference to the file.
+        close(fd);
+        if(view == MAP_FAILED)
+            return false;
+
+        // the scanner walks the file front to back.
+        madvise(view, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+        content = (const char*) view;
+        length = (u64) st.st_size;
+#endif
+        mapped = true;
+        return true;
+    }
+
+    bool File::read() {
+        std::FILE* f = std::fopen(fullpath().c_str(), "rb");
+        if(!f) return false;
+
+        // regular files are read in one call, streams are read until they run dry.
+        if(std::fseek(f, 0, SEEK_END) == 0) {
+            long size = std::ftell(f);
+            if(size > 0) {
+                std::rewind(f);
+                buffer.resize((u64) size);
+                buffer.resize(std::fread(&buffer[0], 1, buffer.size(), f));
+            }
+            else
+                std::rewind(f);
+        }
+
+        char chunk[1 << 16];
+        u64 count;
+        while((count = std::fread(chunk, 1, sizeof(chunk), f)) > 0)
+            buffer.append(chunk, count);
+
+        std::fclose(f);
+
+        content = buffer.data();
+        length = buffer.size();
+        return true;
+    }
+
     bool File::is_loaded() {
         return loaded;
     }
 
+    bool File::is_mapped() {
+        return mapped;
+    }
+
     std::string File::extention() {
 		return find_end_relative(filename, '.');
     }
@@ -60,10 +198,22 @@ namespace io {
         return filename;
     }
 
-    const std::string& File::value() {
+    std::string_view File::value() {
+        return std::string_view(content, length);
+    }
+
+    const char* File::data() {
         return content;
     }
 
+    u64 File::size() {
+        return length;
+    }
+
+    u64 File::hash() {
+        return contentHash;
+    }
+
     std::string File::fullpath() {
         return path + filename;
     }
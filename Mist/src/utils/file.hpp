@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common.hpp"
+#include <string_view>
 
 // it is assumed this class is given the absolute path of the file.
 
@@ -8,30 +9,65 @@ namespace io {
 	class File {
     public:
         File(const std::string& path);
+        ~File();
 
+        File(const File&) = delete;
+        File& operator= (const File&) = delete;
+
+        /// loads the content of the file. Regular files are memory mapped
+        /// read-only, anything else (pipes, devices) is read once into a buffer.
         bool load(bool force = false);
 
+        /// releases the content of the file.
+        void unload();
+
+        /// replaces removed characters at offset with text. The file stops
+        /// being mapped and owns its content from then on.
+        bool edit(u64 offset, u64 removed, std::string_view text);
+
         std::string extention();
         std::string fullpath();
-    
+
         u64 id();
         const std::string& dir();
         const std::string& name();
-        const std::string& value();
+
+        /// a view of the loaded content. This is only valid while the file is loaded.
+        std::string_view value();
+        const char* data();
+        u64 size();
+
+        /// a hash of the loaded content, it is taken when the file is
+        /// loaded or edited. Files with the same content hash the same.
+        u64 hash();
+
         bool is_loaded();
+        bool is_mapped();
 
 
         // optional api
-        
+
         // returns the path of the file relative to the given dir
         std::string relative_path(const std::string& dir);
-    
-    
+
+
         // creates a hash of the filename for easily identifying it.
         static u64 hash_filename(const std::string& filename);
     private:
+        bool map();
+        void unmap();
+        bool read();
+
         // rune* content{nullptr}; // the buffer when converted to unicode.
-        std::string content;
+        const char* content{nullptr};  // start of the content, either the mapping or buffer
+        u64 length{0};
+        u64 contentHash{0};
+        std::string buffer;            // owns the content when the file could not be mapped
+        bool mapped{false};
+
+#ifdef _WIN32
+        void* mapping{nullptr};        // HANDLE of the file mapping object
+#endif
         u64 uid{0};
 
         std::string path;
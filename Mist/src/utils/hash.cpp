@@ -0,0 +1,95 @@
+#include "hash.hpp"
+#include <cstring>
+
+namespace mist {
+    namespace {
+        const u64 Prime1 = 0x9E3779B185EBCA87ull;
+        const u64 Prime2 = 0xC2B2AE3D27D4EB4Full;
+        const u64 Prime3 = 0x165667B19E3779F9ull;
+        const u64 Prime4 = 0x85EBCA77C2B2AE63ull;
+        const u64 Prime5 = 0x27D4EB2F165667C5ull;
+
+        inline u64 rotl(u64 value, u32 count) {
+            return (value << count) | (value >> (64 - count));
+        }
+
+        // the input is read as little endian whatever the host is.
+        inline u64 read64(const u8* p) {
+            u64 value = 0;
+            for(u32 i = 0; i < 8; ++i)
+                value |= (u64) p[i] << (8 * i);
+            return value;
+        }
+
+        inline u32 read32(const u8* p) {
+            return (u32) p[0] | (u32) p[1] << 8 | (u32) p[2] << 16 | (u32) p[3] << 24;
+        }
+
+        inline u64 round(u64 acc, u64 input) {
+            acc += input * Prime2;
+            acc = rotl(acc, 31);
+            return acc * Prime1;
+        }
+
+        inline u64 merge(u64 acc, u64 value) {
+            acc ^= round(0, value);
+            return acc * Prime1 + Prime4;
+        }
+    }
+
+    u64 hash64(const void* data, u64 length, u64 seed) {
+        auto p = (const u8*) data;
+        auto end = p + length;
+        u64 h;
+
+        if(length >= 32) {
+            u64 v1 = seed + Prime1 + Prime2;
+            u64 v2 = seed + Prime2;
+            u64 v3 = seed;
+            u64 v4 = seed - Prime1;
+
+            // four independent lanes, the compiler keeps them in registers.
+            auto limit = end - 32;
+            do {
+                v1 = round(v1, read64(p));
+                v2 = round(v2, read64(p + 8));
+                v3 = round(v3, read64(p + 16));
+                v4 = round(v4, read64(p + 24));
+                p += 32;
+            } while(p <= limit);
+
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = merge(h, v1);
+            h = merge(h, v2);
+            h = merge(h, v3);
+            h = merge(h, v4);
+        }
+        else
+            h = seed + Prime5;
+
+        h += length;
+
+        for(; p + 8 <= end; p += 8) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * Prime1 + Prime4;
+        }
+
+        if(p + 4 <= end) {
+            h ^= (u64) read32(p) * Prime1;
+            h = rotl(h, 23) * Prime2 + Prime3;
+            p += 4;
+        }
+
+        for(; p < end; ++p) {
+            h ^= (u64) *p * Prime5;
+            h = rotl(h, 11) * Prime1;
+        }
+
+        h ^= h >> 33;
+        h *= Prime2;
+        h ^= h >> 29;
+        h *= Prime3;
+        h ^= h >> 32;
+        return h;
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace mist {
+
+    /// A fast non-cryptographic hash of the bytes at data, the 64 bit
+    /// variant of xxHash. It reads 32 bytes per step and the result is the
+    /// same on every platform, so it can name things that are kept on disk.
+    u64 hash64(const void* data, u64 length, u64 seed = 0);
+}
@@ -0,0 +1,120 @@
+#include "interner.hpp"
+
+#include <cstring>
+
+namespace mist {
+    namespace {
+        const u32 InitialSlots = 256;
+        const u32 CacheSize = 256;
+
+        struct CacheEntry {
+            u32 serial{0};
+            u32 id{0};
+            std::string_view name;
+        };
+
+        // the names this thread interned last, indexed by hash.
+        thread_local CacheEntry cache[CacheSize];
+
+        std::atomic<u32> serials{1};
+    }
+
+    Interner::Interner() : serial(serials.fetch_add(1)) {
+        for(auto& page : pages)
+            page.store(nullptr, std::memory_order_relaxed);
+        for(auto& shard : shards)
+            shard.slots.assign(InitialSlots, Slot{0, 0});
+        set(0, std::string_view());
+    }
+
+    Interner::~Interner() {
+        for(auto& page : pages)
+            delete[] page.load(std::memory_order_relaxed);
+    }
+
+    u32 Interner::hash(std::string_view str) {
+        // FNV-1a, identifiers are short so anything heavier costs more than it saves.
+        u32 h = 2166136261u;
+        for(char ch : str) {
+            h ^= (u8) ch;
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    u32 Interner::intern(std::string_view str) {
+        if(str.empty())
+            return 0;
+
+        u32 h = hash(str);
+        auto& entry = cache[h & (CacheSize - 1)];
+        if(entry.serial == serial && entry.name == str)
+            return entry.id;
+
+        // the low bits pick the slot, so the shard comes from the high ones.
+        auto& shard = shards[h >> (32 - ShardBits)];
+        u32 id = 0;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            u32 mask = (u32) shard.slots.size() - 1;
+            for(u32 i = h & mask;; i = (i + 1) & mask) {
+                auto& slot = shard.slots[i];
+                if(slot.id == 0) {
+                    id = next.fetch_add(1, std::memory_order_relaxed);
+                    slot.hash = h;
+                    slot.id = id;
+                    set(id, std::string_view(shard.store(str), str.size()));
+                    // kept at most half full so probe runs stay short.
+                    if(++shard.count * 2 > shard.slots.size())
+                        shard.grow();
+                    break;
+                }
+                if(slot.hash == h && get(slot.id) == str) {
+                    id = slot.id;
+                    break;
+                }
+            }
+        }
+
+        entry.serial = serial;
+        entry.id = id;
+        entry.name = get(id);
+        return id;
+    }
+
+    void Interner::set(u32 id, std::string_view str) {
+        auto& slot = pages[id >> PageBits];
+        auto page = slot.load(std::memory_order_acquire);
+        if(!page) {
+            // two shards can reach a new page together, the loser frees its copy.
+            auto fresh = new std::string_view[PageSize];
+            if(slot.compare_exchange_strong(page, fresh, std::memory_order_acq_rel))
+                page = fresh;
+            else
+                delete[] fresh;
+        }
+        page[id & (PageSize - 1)] = str;
+    }
+
+    const char* Interner::Shard::store(std::string_view str) {
+        auto result = (char*) arena.alloc(str.size(), 1);
+        std::memcpy(result, str.data(), str.size());
+        return result;
+    }
+
+    void Interner::Shard::grow() {
+        std::vector<Slot> old(slots.size() * 2, Slot{0, 0});
+        old.swap(slots);
+
+        // the cached hashes mean no name is read again.
+        u32 mask = (u32) slots.size() - 1;
+        for(auto& slot : old) {
+            if(slot.id == 0)
+                continue;
+            u32 i = slot.hash & mask;
+            while(slots[i].id != 0)
+                i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+    }
+}
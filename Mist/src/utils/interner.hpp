@@ -0,0 +1,78 @@
+#pragma once
+
+#include "common.hpp"
+#include "arena.hpp"
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace mist {
+
+    /// Names are stored once in a bump arena and handed out as dense ids, so
+    /// two names are equal exactly when their ids are. Id 0 is the empty name
+    /// and never refers to an identifier. Everything is freed with the interner.
+    ///
+    /// Any number of threads may intern at once. The table is split into
+    /// shards by hash, each with its own lock, table and arena, and every
+    /// thread keeps a small cache of the names it interned last so repeated
+    /// names do not take a lock. Ids are shared between all threads.
+    class Interner {
+        public:
+            Interner();
+            ~Interner();
+
+            Interner(const Interner&) = delete;
+            Interner& operator= (const Interner&) = delete;
+
+            /// the id of str, adding a copy of it the first time it is seen.
+            u32 intern(std::string_view str);
+
+            /// the text of a name, valid for the life of the interner. Reading
+            /// an id does not lock, it only has to come from a finished intern.
+            inline std::string_view get(u32 id) const {
+                return pages[id >> PageBits].load(std::memory_order_acquire)[id & (PageSize - 1)];
+            }
+
+            /// the number of ids handed out, including the empty name.
+            inline u32 size() const { return next.load(std::memory_order_relaxed); }
+
+            static u32 hash(std::string_view str);
+
+            static const u32 ShardBits = 4;
+
+        private:
+            static const u32 PageBits = 14;
+            static const u32 PageSize = 1 << PageBits;
+            static const u32 MaxPages = 1 << 14;
+
+            struct Slot {
+                u32 hash;
+                u32 id;         /// 0 is an empty slot
+            };
+
+            // on its own cache line so threads working on different shards
+            // do not fight over the lock.
+            struct alignas(64) Shard {
+                std::mutex mutex;
+                std::vector<Slot> slots;    /// open addressing, the size is a power of two
+                u32 count{0};
+                Arena arena;                /// the text of the names in the shard
+
+                /// copies str into the arena of the shard.
+                const char* store(std::string_view str);
+
+                void grow();
+            };
+
+            /// records the text of a new id, creating its page if needed.
+            void set(u32 id, std::string_view str);
+
+            Shard shards[1 << ShardBits];
+            // names by id in pages that never move, so get can read them
+            // while other threads add names.
+            std::atomic<std::string_view*> pages[MaxPages];
+            std::atomic<u32> next{1};
+            u32 serial;                     /// tells the thread caches of different interners apart
+    };
+}
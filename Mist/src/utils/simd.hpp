@@ -0,0 +1,197 @@
+#pragma once
+
+#include "common.hpp"
+#include <cstring>
+
+// Block-at-a-time character classification used by the scanner. Every
+// routine takes a half-open range [p, end) and never reads past end, so
+// they are safe to run directly over a memory mapped file.
+//
+// AVX2 is used when the compiler targets it, SSE2 on any other x86-64
+// build and a scalar loop everywhere else.
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define MIST_SIMD_AVX2 1
+    #define MIST_SIMD_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define MIST_SIMD_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace mist {
+namespace simd {
+
+    inline u32 ctz(u32 mask) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (u32) index;
+#else
+        return (u32) __builtin_ctz(mask);
+#endif
+    }
+
+    inline u32 clz(u32 mask) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse(&index, mask);
+        return 31 - (u32) index;
+#else
+        return (u32) __builtin_clz(mask);
+#endif
+    }
+
+    inline u32 popcount(u32 mask) {
+#ifdef _MSC_VER
+        return (u32) __popcnt(mask);
+#else
+        return (u32) __builtin_popcount(mask);
+#endif
+    }
+
+    /// whitespace other than '\n', newlines are tokens in Mist.
+    inline bool is_blank(char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\v' || ch == '\f';
+    }
+
+    inline bool is_ident(char ch) {
+        return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+               (ch >= '0' && ch <= '9') || ch == '_';
+    }
+
+#if MIST_SIMD_SSE2
+    // lanes that hold a blank character.
+    inline __m128i blank_lanes(__m128i v) {
+        __m128i m = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\v')));
+        return _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\f')));
+    }
+
+    // lanes that hold [a-zA-Z0-9_]. Bytes above 0x7f are negative as signed
+    // chars so they fail every range check.
+    inline __m128i ident_lanes(__m128i v) {
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                      _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+        __m128i under = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+        return _mm_or_si128(_mm_or_si128(alpha, digit), under);
+    }
+#endif
+
+#if MIST_SIMD_AVX2
+    inline __m256i blank_lanes(__m256i v) {
+        __m256i m = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\v')));
+        return _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\f')));
+    }
+
+    inline __m256i ident_lanes(__m256i v) {
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+        __m256i under = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+        return _mm256_or_si256(_mm256_or_si256(alpha, digit), under);
+    }
+#endif
+
+// Walks [p, end) until the first character for which LANES reports false (or
+// IS reports false on the scalar tail).
+#if MIST_SIMD_AVX2
+    #define MIST_SIMD_SKIP(LANES, IS) \
+        while(end - p >= 32) { \
+            __m256i v = _mm256_loadu_si256((const __m256i*) p); \
+            u32 miss = ~(u32) _mm256_movemask_epi8(LANES(v)); \
+            if(miss) return p + ctz(miss); \
+            p += 32; \
+        } \
+        while(end - p >= 16) { \
+            __m128i v = _mm_loadu_si128((const __m128i*) p); \
+            u32 miss = ~(u32) _mm_movemask_epi8(LANES(v)) & 0xFFFF; \
+            if(miss) return p + ctz(miss); \
+            p += 16; \
+        } \
+        while(p < end && IS(*p)) ++p; \
+        return p;
+#elif MIST_SIMD_SSE2
+    #define MIST_SIMD_SKIP(LANES, IS) \
+        while(end - p >= 16) { \
+            __m128i v = _mm_loadu_si128((const __m128i*) p); \
+            u32 miss = ~(u32) _mm_movemask_epi8(LANES(v)) & 0xFFFF; \
+            if(miss) return p + ctz(miss); \
+            p += 16; \
+        } \
+        while(p < end && IS(*p)) ++p; \
+        return p;
+#else
+    #define MIST_SIMD_SKIP(LANES, IS) \
+        while(p < end && IS(*p)) ++p; \
+        return p;
+#endif
+
+    /// returns the first character that isn't a blank.
+    inline const char* skip_blanks(const char* p, const char* end) {
+        MIST_SIMD_SKIP(blank_lanes, is_blank)
+    }
+
+    /// returns the first character that can not be part of an identifier.
+    inline const char* skip_ident(const char* p, const char* end) {
+        MIST_SIMD_SKIP(ident_lanes, is_ident)
+    }
+
+#undef MIST_SIMD_SKIP
+
+    /// returns the first occurence of ch or end. The C library already
+    /// vectorizes memchr, so there is nothing to gain from doing it here.
+    inline const char* find(const char* p, const char* end, char ch) {
+        auto r = (const char*) std::memchr(p, ch, (size_t) (end - p));
+        return r ? r : end;
+    }
+
+    /// returns the first occurence of either a or b or end.
+    inline const char* find_either(const char* p, const char* end, char a, char b) {
+#if MIST_SIMD_SSE2
+        __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
+        while(end - p >= 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*) p);
+            u32 hit = (u32) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+            if(hit) return p + ctz(hit);
+            p += 16;
+        }
+#endif
+        while(p < end && *p != a && *p != b) ++p;
+        return p;
+    }
+
+    /// calls fn with the offset from p of every newline in [p, end), in order.
+    template <typename F>
+    inline void for_each_newline(const char* p, const char* end, F fn) {
+        const char* begin = p;
+#if MIST_SIMD_SSE2
+        __m128i nl = _mm_set1_epi8('\n');
+        while(end - p >= 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*) p);
+            u32 hit = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+            for(; hit; hit &= hit - 1)
+                fn((u64) (p - begin) + ctz(hit));
+            p += 16;
+        }
+#endif
+        for(; p < end; ++p)
+            if(*p == '\n')
+                fn((u64) (p - begin));
+    }
+}
+}
@@ -0,0 +1,216 @@
+#include "source_manager.hpp"
+#include "file.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+
+namespace io {
+    namespace {
+        // offsets are 32 bits, no range may reach past this.
+        const u64 End = (u64) 1 << 32;
+
+        // room left after a file for edits before it has to move.
+        inline u64 capacity_for(u64 size) {
+            return size + size / 8 + 256;
+        }
+
+        void build_lines(std::vector<u32>& lines, const char* data, u64 length) {
+            lines.clear();
+            lines.reserve(length / 32 + 1);
+            lines.push_back(0);
+            mist::simd::for_each_newline(data, data + length, [&lines](u64 offset) {
+                lines.push_back((u32) offset + 1);
+            });
+        }
+    }
+
+    const char* status_message(SourceStatus status) {
+        switch(status) {
+            case Source_Ok:
+                return "no error";
+            case Source_Unreadable:
+                return "failed to load file";
+            case Source_Outside:
+                return "edit is outside of the file";
+            case Source_Full:
+                return "the source address space is full";
+        }
+        return "unknown error";
+    }
+
+    SourceStatus SourceManager::load(File* file) {
+        u32 stale = 0;      // the range of an earlier load, 0 for none
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto index = find(file);
+            if(index != sources.size()) {
+                if(file->is_loaded())
+                    return Source_Ok;
+                stale = sources[index].base;
+            }
+        }
+
+        // reading, hashing and the line table are done without the lock, so
+        // files loaded by other threads do not wait on them.
+        if(!file->load())
+            return Source_Unreadable;
+        std::vector<u32> lines;
+        build_lines(lines, file->data(), file->size());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto index = find(file);
+        // another thread gave the file a range while it was loading.
+        if(index != sources.size() && sources[index].base != stale)
+            return Source_Ok;
+
+        // a file loaded again may have changed, it is given a new range.
+        if(index != sources.size())
+            release(index);
+        index = allocate(capacity_for(file->size()));
+        if(index == sources.size()) {
+            file->unload();
+            return Source_Full;
+        }
+
+        sources[index].file = file;
+        sources[index].lines = std::move(lines);
+        return Source_Ok;
+    }
+
+    u32 SourceManager::base(File* file) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto index = find(file);
+        return index == sources.size() ? 0 : sources[index].base;
+    }
+
+    SourceStatus SourceManager::edit(File* file, u64 offset, u64 removed, std::string_view text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto index = find(file);
+        if(index == sources.size() || !file->is_loaded() || offset > file->size() || removed > file->size() - offset)
+            return Source_Outside;
+
+        // the end of file token sits one past the last character.
+        u64 size = file->size() - removed + text.size();
+        if(size + 1 > sources[index].capacity) {
+            u64 capacity = capacity_for(size);
+            if(index + 1 == sources.size() && sources[index].base + capacity <= End) {
+                // the last range grows in place.
+                sources[index].capacity = (u32) capacity;
+                next = sources[index].base + capacity;
+            }
+            else {
+                auto moved = allocate(capacity);
+                if(moved == sources.size())
+                    return Source_Full;
+                // splitting a range before the old one moves it up by one.
+                index = find(file);
+                sources[moved].file = file;
+                sources[moved].lines = std::move(sources[index].lines);
+                release(index);
+                index = find(file);
+            }
+        }
+
+        if(!file->edit(offset, removed, text))
+            return Source_Outside;
+
+        // a line starting in (offset, offset + removed] followed a removed newline.
+        auto& lines = sources[index].lines;
+        auto first = std::upper_bound(lines.begin(), lines.end(), (u32) offset);
+        auto last = std::upper_bound(first, lines.end(), (u32) (offset + removed));
+
+        i64 shift = (i64) text.size() - (i64) removed;
+        for(auto iter = last; iter != lines.end(); ++iter)
+            *iter = (u32) (*iter + shift);
+
+        std::vector<u32> added;
+        mist::simd::for_each_newline(text.data(), text.data() + text.size(), [&added, offset](u64 at) {
+            added.push_back((u32) (offset + at + 1));
+        });
+        lines.insert(lines.erase(first, last), added.begin(), added.end());
+
+        return Source_Ok;
+    }
+
+    File* SourceManager::file(u32 offset) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto index = find(offset);
+        return index == sources.size() ? nullptr : sources[index].file;
+    }
+
+    Location SourceManager::resolve(u32 offset) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Location location;
+        auto index = find(offset);
+        if(index == sources.size())
+            return location;
+
+        auto& source = sources[index];
+        u32 local = offset - source.base;
+        auto iter = std::upper_bound(source.lines.begin(), source.lines.end(), local);
+        location.file = source.file;
+        location.line = (u32) (iter - source.lines.begin()) - 1;
+        location.column = local - source.lines[location.line];
+        return location;
+    }
+
+    u64 SourceManager::find(File* file) {
+        for(u64 i = 0; i < sources.size(); ++i)
+            if(sources[i].file == file)
+                return i;
+        return sources.size();
+    }
+
+    u64 SourceManager::find(u32 offset) {
+        // the last range starting at or before offset.
+        auto iter = std::upper_bound(sources.begin(), sources.end(), offset, [](u32 offset, const Source& source) {
+            return offset < source.base;
+        });
+        if(iter == sources.begin())
+            return sources.size();
+        --iter;
+        if(!iter->file || offset - iter->base >= iter->capacity)
+            return sources.size();
+        return (u64) (iter - sources.begin());
+    }
+
+    u64 SourceManager::allocate(u64 capacity) {
+        for(u64 i = 0; i < sources.size(); ++i) {
+            auto& source = sources[i];
+            if(source.file || source.capacity < capacity)
+                continue;
+            // the rest of a larger range stays unused after it.
+            if(source.capacity > capacity) {
+                Source rest{nullptr, (u32) (source.base + capacity), (u32) (source.capacity - capacity), {}};
+                source.capacity = (u32) capacity;
+                sources.insert(sources.begin() + i + 1, std::move(rest));
+            }
+            return i;
+        }
+
+        if(next + capacity > End)
+            return sources.size();
+        sources.push_back(Source{nullptr, (u32) next, (u32) capacity, {}});
+        next += capacity;
+        return sources.size() - 1;
+    }
+
+    void SourceManager::release(u64 index) {
+        sources[index].file = nullptr;
+        sources[index].lines = std::vector<u32>();
+        if(index + 1 < sources.size() && !sources[index + 1].file) {
+            sources[index].capacity += sources[index + 1].capacity;
+            sources.erase(sources.begin() + index + 1);
+        }
+        if(index > 0 && !sources[index - 1].file) {
+            sources[index - 1].capacity += sources[index].capacity;
+            sources.erase(sources.begin() + index);
+            --index;
+        }
+        // an unused range at the end goes back to the space after it.
+        if(index + 1 == sources.size()) {
+            next = sources[index].base;
+            sources.pop_back();
+        }
+    }
+}
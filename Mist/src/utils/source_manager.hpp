@@ -0,0 +1,76 @@
+#pragma once
+
+#include "common.hpp"
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace io {
+    class File;
+
+    /// a position resolved to its file, line and column count from 0.
+    struct Location {
+        File* file{nullptr};
+        u32 line{0};
+        u32 column{0};
+    };
+
+    /// why a load or an edit failed.
+    enum SourceStatus : u8 {
+        Source_Ok,
+        Source_Unreadable,          /// the file could not be read
+        Source_Outside,             /// the edit is not inside a loaded file
+        Source_Full,                /// no range of the address space is large enough
+    };
+
+    /// the message a failed status is reported with.
+    const char* status_message(SourceStatus status);
+
+    /// Every loaded file is given a range of one address space, so a position
+    /// anywhere in the program is a single 32 bit offset. Offset 0 is not part
+    /// of any file. The line table of a file is built when it is loaded and is
+    /// only searched when a position has to be printed. A range a file moved
+    /// out of is given to the next file that fits in it.
+    class SourceManager {
+        public:
+            /// loads file and gives it a range.
+            SourceStatus load(File* file);
+
+            /// the offset of the first character of a loaded file.
+            u32 base(File* file);
+
+            /// replaces removed characters at offset with text and updates the
+            /// line table. The file moves to a new range if it outgrows its own,
+            /// the file is left as it was when there is none.
+            SourceStatus edit(File* file, u64 offset, u64 removed, std::string_view text);
+
+            /// the file that holds offset, or nullptr.
+            File* file(u32 offset);
+
+            Location resolve(u32 offset);
+
+        private:
+            struct Source {
+                File* file;                 /// nullptr for a range no file uses
+                u32 base;
+                u32 capacity;               /// size of the range, edits may grow the file up to it
+                std::vector<u32> lines;     /// offset of the first character of each line, from base
+            };
+
+            // the index of the source, or sources.size().
+            u64 find(File* file);
+            u64 find(u32 offset);
+
+            // the index of an unused range of at least capacity, the first one
+            // that fits or a new one at the end. sources.size() when there is
+            // no room, indices after the range may have changed.
+            u64 allocate(u64 capacity);
+
+            // makes the range at index unused and merges it with unused neighbours.
+            void release(u64 index);
+
+            std::vector<Source> sources;    /// sorted by base, ranges no file uses are kept for reuse
+            u64 next{1};                    /// the end of the last range
+            std::mutex mutex;               /// files are loaded from several threads
+    };
+}
@@ -0,0 +1,106 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace mist {
+    ThreadPool::ThreadPool(u32 count) {
+        workers.reserve(count);
+        for(u32 i = 0; i < count; ++i)
+            workers.emplace_back([this]() { work(); });
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+        for(auto& worker : workers)
+            worker.join();
+    }
+
+    void ThreadPool::submit(std::function<void()> job) {
+        // without workers the job runs right away.
+        if(workers.empty()) {
+            job();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        ready.notify_one();
+    }
+
+    void ThreadPool::wait() {
+        // the caller runs queued jobs too instead of only sleeping, jobs may queue more.
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true) {
+            ready.wait(lock, [this]() { return !jobs.empty() || running == 0; });
+            if(jobs.empty())
+                return;
+            auto job = std::move(jobs.front());
+            jobs.pop_front();
+            ++running;
+
+            lock.unlock();
+            job();
+            lock.lock();
+            --running;
+        }
+    }
+
+    void ThreadPool::parallel_for(u32 count, const std::function<void(u32)>& job) {
+        struct Batch {
+            std::atomic<u32> next{0};
+            std::atomic<u32> left{0};
+            std::mutex mutex;
+            std::condition_variable done;
+        };
+
+        // helpers can start after every index is taken, they only touch the batch then.
+        auto batch = std::make_shared<Batch>();
+        batch->left = count;
+        auto run = [batch, count, &job]() {
+            for(u32 i = batch->next++; i < count; i = batch->next++) {
+                job(i);
+                if(--batch->left == 0) {
+                    std::lock_guard<std::mutex> lock(batch->mutex);
+                    batch->done.notify_all();
+                }
+            }
+        };
+
+        u32 helpers = count > 1 ? std::min(count - 1, size()) : 0;
+        for(u32 i = 0; i < helpers; ++i)
+            submit(run);
+        run();
+
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->done.wait(lock, [&batch]() { return batch->left == 0; });
+    }
+
+    void ThreadPool::work() {
+        while(true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if(jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                ++running;
+            }
+
+            job();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            // wakes a caller blocked in wait, the workers go back to sleep.
+            if(--running == 0 && jobs.empty())
+                ready.notify_all();
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "common.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mist {
+
+    /// A fixed set of worker threads that run jobs in the order they were submitted.
+    class ThreadPool {
+        public:
+            /// starts count workers, the thread calling parallel_for works as well.
+            ThreadPool(u32 count);
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator= (const ThreadPool&) = delete;
+
+            void submit(std::function<void()> job);
+
+            /// blocks until every submitted job has finished, running queued jobs
+            /// on the calling thread meanwhile. This must not be called from a job.
+            void wait();
+
+            /// runs job(i) for every i in [0, count) and returns once all of them are done.
+            /// The caller takes indices too, so this can be used from inside a job.
+            void parallel_for(u32 count, const std::function<void(u32)>& job);
+
+            inline u32 size() const { return (u32) workers.size(); }
+
+        private:
+            void work();
+
+            std::vector<std::thread> workers;
+            std::deque<std::function<void()>> jobs;
+            std::mutex mutex;
+            std::condition_variable ready;   /// a job was queued, the pool ran idle or is stopping
+            u32 running{0};
+            bool stopping{false};
+    };
+}
@@ -0,0 +1,62 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace mist {
+    namespace trace {
+        namespace {
+            const u32 Capacity = 1 << 14;   // events kept per thread, a power of two
+
+            struct Ring {
+                Event events[Capacity];
+                std::atomic<u64> head{0};   // events ever recorded, the next goes to head % Capacity
+            };
+
+            // rings outlive their threads so they can be read after the run.
+            std::mutex mutex;
+            std::vector<std::unique_ptr<Ring>> rings;
+
+            Ring* ring() {
+                static thread_local Ring* local = nullptr;
+                if(!local) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    rings.emplace_back(new Ring);
+                    local = rings.back().get();
+                }
+                return local;
+            }
+        }
+
+        void set_level(Level level) {
+            active.store(level, std::memory_order_relaxed);
+        }
+
+        void record(Level level, const char* name, const char* detail, u32 offset, u32 value) {
+            auto r = ring();
+            u64 head = r->head.load(std::memory_order_relaxed);
+            u64 time = (u64) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            r->events[head & (Capacity - 1)] = Event{time, name, detail, offset, value, level};
+            r->head.store(head + 1, std::memory_order_release);
+        }
+
+        std::vector<Record> collect() {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<Record> records;
+            for(u32 thread = 0; thread < rings.size(); ++thread) {
+                auto& r = *rings[thread];
+                u64 head = r.head.load(std::memory_order_acquire);
+                u64 first = head > Capacity ? head - Capacity : 0;
+                for(u64 i = first; i < head; ++i)
+                    records.push_back(Record{thread, r.events[i & (Capacity - 1)]});
+            }
+            std::stable_sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+                return a.event.time < b.event.time;
+            });
+            return records;
+        }
+    }
+}
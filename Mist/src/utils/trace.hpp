@@ -0,0 +1,63 @@
+#pragma once
+
+#include "common.hpp"
+#include <atomic>
+#include <vector>
+
+// The highest level that is compiled in, 0 compiles every trace out. The
+// arguments of a trace above it are not even evaluated.
+#ifndef MIST_TRACE_LEVEL
+    #define MIST_TRACE_LEVEL 0
+#endif
+
+#if MIST_TRACE_LEVEL > 0
+    #define MIST_TRACE(lvl, name, detail, offset, value) \
+        do { \
+            if((lvl) <= MIST_TRACE_LEVEL && (lvl) <= mist::trace::level()) \
+                mist::trace::record((lvl), (name), (detail), (offset), (value)); \
+        } while(0)
+#else
+    #define MIST_TRACE(lvl, name, detail, offset, value) do {} while(0)
+#endif
+
+namespace mist {
+    namespace trace {
+        enum Level : u8 {
+            Off,
+            Info,       /// once per module
+            Debug,      /// once per declaration
+            Verbose     /// once per token or expression
+        };
+
+        /// a step of the compiler. The strings are not copied, they have to
+        /// live until the trace is dumped.
+        struct Event {
+            u64 time;               /// nanoseconds of the steady clock
+            const char* name;
+            const char* detail;     /// the token kind, a file name or nullptr
+            u32 offset;             /// a position in the io::SourceManager, 0 if there is none
+            u32 value;
+            u8 level;
+        };
+
+        /// an event and the thread that recorded it.
+        struct Record {
+            u32 thread;             /// threads are numbered in the order they first traced
+            Event event;
+        };
+
+        /// events above the level are dropped when they happen.
+        void set_level(Level level);
+
+        inline std::atomic<u8> active{Off};
+        inline Level level() { return (Level) active.load(std::memory_order_relaxed); }
+
+        /// adds an event to the ring of the calling thread. Only that thread
+        /// writes the ring, once it is full the oldest events are overwritten.
+        void record(Level level, const char* name, const char* detail, u32 offset, u32 value);
+
+        /// the events still held by the rings of every thread, oldest first.
+        /// This must only be called while no thread is tracing.
+        std::vector<Record> collect();
+    }
+}